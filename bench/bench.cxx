@@ -0,0 +1,2118 @@
+// Headless benchmarks of CPU side code; no window nor GL context is needed.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <list>
+#include <string>
+#include <thread>
+
+#include <log.h>
+#include <trig.h>
+#include <m44.h>
+#include <geometry.h>
+#include <bvh.h>
+#include <hittest.h>
+#include <renderable.h>
+#include <scenemesh.h>
+#include <scenestore.h>
+#include <spatialgrid.h>
+#include <trisoa.h>
+#include <frustum.h>
+#include <threadpool.h>
+#include <cubeshape.h>
+#include <cubebatch.h>
+#include <quat.h>
+#include <camera.h>
+#include <textlayout.h>
+#include <textmesh.h>
+#include <overlaybatch.h>
+#include <vertexbatch.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double nsSince(Clock::time_point start, int ops) {
+	return chrono::duration<double, nano>(Clock::now() - start).count() / ops;
+}
+
+// every heap allocation of the process goes through here, so benchmarks can report allocations per operation
+static atomic<long long> allocations(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+// gcc sees malloc inside replaced operator new and free inside replaced delete, and takes them for a mismatched pair
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, memory_order_relaxed);
+
+	void* p = malloc(size ? size : 1);
+	if (!p) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+// results land here, so the optimizer cannot drop the measured work
+static volatile float sink;
+
+// runs op(i) for i in [0, ops) in several samples after a warm up; median is reported as it is not thrown off by a single slow sample
+template <typename F> static void measure(const char* name, int ops, F op) {
+	const int SAMPLES = 7;
+
+	for (int i = 0; i < ops; ++i) {
+		op(i);
+	}
+
+	double samples[SAMPLES];
+	long long allocated = allocations;
+	for (double& each : samples) {
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < ops; ++i) {
+			op(i);
+		}
+		each = nsSince(start, ops);
+	}
+	allocated = allocations - allocated;
+
+	sort(samples, samples + SAMPLES);
+	printf("  %-46s %12.1f ns/op (min %10.1f)  %8.2f allocs/op\n", name, samples[SAMPLES / 2], samples[0], (double)allocated / ((double)SAMPLES * ops));
+}
+
+// small random triangles scattered in a box, similar to what floodcount() produces but in bulk
+static vector<Triangle> randomScene(int count, mt19937& rng) {
+	uniform_real_distribution<float> place(-20, 20);
+	uniform_real_distribution<float> spread(-0.2f, 0.2f);
+
+	vector<Triangle> tris(count);
+	for (int i = 0; i < count; ++i) {
+		Vec3F c = { place(rng), place(rng), place(rng) };
+		tris[i].id = i / 12;
+		for (Vec3F& v : tris[i].vertices) {
+			v = { c.x + spread(rng), c.y + spread(rng), c.z + spread(rng) };
+		}
+	}
+
+	return tris;
+}
+
+static vector<Line> randomRays(int count, mt19937& rng) {
+	uniform_real_distribution<float> origin(-2, 2);
+	uniform_real_distribution<float> target(-20, 20);
+
+	vector<Line> rays(count);
+	for (Line& l : rays) {
+		l.first = { origin(rng), origin(rng), 25 };
+		l.second = { target(rng), target(rng), -20 };
+	}
+
+	return rays;
+}
+
+static bool sameHits(const HitTest& a, const HitTest& b) {
+	if (a.hits.size() != b.hits.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < a.hits.size(); ++i) {
+		if (a.hits[i].id != b.hits[i].id) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool sameFirstHit(const HitTest& a, const HitTest& b) {
+	if (a.hits.empty() || b.hits.empty()) {
+		return a.hits.empty() == b.hits.empty();
+	}
+
+	const HitPosition& ha = a.hits.front();
+	const HitPosition& hb = b.hits.front();
+
+	Vec3F diff = ha.v;
+	diff.sub(hb.v);
+
+	return ha.id == hb.id && diff.len() < 1e-3f;
+}
+
+static bool benchPicking(int triangles) {
+	mt19937 rng(triangles);
+	vector<Triangle> scene = randomScene(triangles, rng);
+	vector<Line> rays = randomRays(triangles >= 100000 ? 50 : 500, rng);
+
+	Clock::time_point start = Clock::now();
+	BVH bvh;
+	bvh.build(scene);
+	double buildNs = nsSince(start, 1);
+
+	start = Clock::now();
+	bvh.refit(scene);
+	double refitNs = nsSince(start, 1);
+
+	int mismatches = 0;
+	int hits = 0;
+	double referenceNs = 0;
+	double linearNs = 0;
+	double bvhNs = 0;
+
+	HitTest reference;
+	reference.method = HitReference;
+	reference.tris = scene;
+
+	HitTest linear;
+	linear.tris = scene;
+
+	HitTest accelerated;
+
+	TriangleSoA soa;
+	soa.assign(scene, bvh.order);
+	HitTest packed;
+	double packedNs = 0;
+
+	HitTest closest;
+	closest.query = HitClosest;
+	double closestNs = 0;
+
+	for (const Line& l : rays) {
+		reference.line = l;
+		start = Clock::now();
+		reference.check();
+		referenceNs += nsSince(start, 1);
+
+		linear.line = l;
+		start = Clock::now();
+		linear.check();
+		linearNs += nsSince(start, 1);
+
+		accelerated.line = l;
+		start = Clock::now();
+		accelerated.check(scene, bvh);
+		bvhNs += nsSince(start, 1);
+
+		packed.line = l;
+		start = Clock::now();
+		packed.check(soa, bvh);
+		packedNs += nsSince(start, 1);
+
+		closest.line = l;
+		start = Clock::now();
+		closest.check(soa, bvh);
+		closestNs += nsSince(start, 1);
+
+		hits += (int)linear.hits.size();
+		mismatches += sameFirstHit(reference, linear) && sameHits(linear, accelerated) && sameHits(linear, packed) ? 0 : 1;
+		mismatches += closest.hits.size() <= 1 && sameFirstHit(closest, packed) ? 0 : 1;
+	}
+
+	int rayCount = (int)rays.size();
+	printf("picking %7i tris: reference %12.0f ns/ray, direct %12.0f ns/ray, bvh %10.0f ns/ray, bvh+simd %10.0f ns/ray, closest %10.0f ns/ray (%5.1fx), build %.2f ms, refit %.2f ms, nodes %i, hits %i, mismatches %i\n",
+		triangles, referenceNs / rayCount, linearNs / rayCount, bvhNs / rayCount, packedNs / rayCount, closestNs / rayCount, referenceNs / closestNs,
+		buildNs / 1e6, refitNs / 1e6, (int)bvh.nodes.size(), hits, mismatches);
+
+	return mismatches == 0;
+}
+
+// randomized cross check of HitMollerTrumbore against HitReference on dense scene, where most rays hit something
+static bool verifyHitMethods(int rounds) {
+	mt19937 rng(rounds);
+	int mismatches = 0;
+	int hits = 0;
+
+	for (int i = 0; i < rounds; ++i) {
+		vector<Triangle> scene = randomScene(200, rng);
+		for (Triangle& t : scene) {
+			for (Vec3F& v : t.vertices) {
+				v.mult(0.1f);
+			}
+		}
+
+		// aim at a random vertex, shifted a bit, so most rays go through the cluster
+		uniform_int_distribution<int> pick(0, (int)scene.size() - 1);
+		uniform_real_distribution<float> jitter(-0.005f, 0.005f);
+		Vec3F target = scene[pick(rng)].vertices[0];
+		target.add({ jitter(rng), jitter(rng), jitter(rng) });
+
+		HitTest reference;
+		reference.method = HitReference;
+		reference.tris = scene;
+		reference.line = randomRays(1, rng).front();
+		reference.line.second = target;
+
+		HitTest direct;
+		direct.tris = scene;
+		direct.line = reference.line;
+
+		reference.check();
+		direct.check();
+
+		hits += direct.hits.empty() ? 0 : 1;
+		if (!sameFirstHit(reference, direct)) {
+			++mismatches;
+		}
+	}
+
+	printf("hit methods: %i rays, %i with hits, first hit mismatches %i\n", rounds, hits, mismatches);
+	return mismatches == 0;
+}
+
+// every kernel has to give bit exact hits of HitTest::intersect; reports throughput of each
+static bool benchSimdKernels(int triangles) {
+	mt19937 rng(triangles + 1);
+	vector<Triangle> scene = randomScene(triangles, rng);
+	vector<Line> rays = randomRays(50, rng);
+
+	// aim at centers of random triangles, so every ray hits something
+	uniform_int_distribution<int> pick(0, triangles - 1);
+	for (Line& l : rays) {
+		const Triangle& t = scene[pick(rng)];
+		l.second = t.vertices[0];
+		l.second.add(t.vertices[1]).add(t.vertices[2]).mult(1.0f / 3);
+	}
+
+	TriangleSoA soa;
+	soa.assign(scene);
+
+	int mismatches = 0;
+	int hits = 0;
+	vector<SoAHit> expected;
+	for (const Line& l : rays) {
+		Vec3F dir = l.second;
+		dir.sub(l.first);
+
+		expected.clear();
+		for (int i = 0; i < (int)scene.size(); ++i) {
+			float t, u, v;
+			if (HitTest::intersect(l.first, dir, scene[i], t, u, v)) {
+				expected.push_back({ i, t, u, v });
+			}
+		}
+		hits += (int)expected.size();
+
+		for (int level = SimdScalar; level <= SimdAVX2; ++level) {
+			vector<SoAHit> got;
+			soaKernel((SimdLevel)level)(soa, 0, soa.count, l.first, dir, FLT_MAX, got);
+
+			bool same = got.size() == expected.size();
+			for (size_t i = 0; same && i < got.size(); ++i) {
+				same = got[i].index == expected[i].index && got[i].t == expected[i].t && got[i].u == expected[i].u && got[i].v == expected[i].v;
+			}
+
+			mismatches += same ? 0 : 1;
+		}
+	}
+
+	printf("simd kernels %i tris, %i rays, %i hits, best supported: %s, mismatches %i\n", triangles, (int)rays.size(), hits, simdName(detectSimd()), mismatches);
+
+	vector<SoAHit> out;
+	for (int level = SimdScalar; level <= SimdAVX2; ++level) {
+		SoAKernel kernel = soaKernel((SimdLevel)level);
+
+		Clock::time_point start = Clock::now();
+		for (const Line& l : rays) {
+			Vec3F dir = l.second;
+			dir.sub(l.first);
+
+			out.clear();
+			kernel(soa, 0, soa.count, l.first, dir, FLT_MAX, out);
+		}
+		double ns = nsSince(start, (int)rays.size() * triangles);
+
+		printf("  %-6s %8.1f Mtris/s%s\n", simdName((SimdLevel)level), 1e3 / ns, level > detectSimd() ? " (not supported, fell back)" : "");
+	}
+
+	return mismatches == 0;
+}
+
+// area selection: grid of rays from one eye point, as renderablesInRect makes them, against one HitClosest check per ray
+static bool benchPacket(int triangles, int side) {
+	mt19937 rng(triangles + side);
+	vector<Triangle> scene = randomScene(triangles, rng);
+
+	BVH bvh;
+	bvh.build(scene);
+	TriangleSoA soa;
+	soa.assign(scene, bvh.order);
+
+	// 4x4 tiles, one tile per packet
+	PacketHitTest packet;
+	for (int tileY = 0; tileY < side; tileY += 4) {
+		for (int tileX = 0; tileX < side; tileX += 4) {
+			for (int y = tileY; y < tileY + 4; ++y) {
+				for (int x = tileX; x < tileX + 4; ++x) {
+					Line l;
+					l.first = { 0, 0, 25 };
+					l.second = { -5 + 10.0f * x / side, -5 + 10.0f * y / side, -20 };
+					packet.rays.push_back(l);
+				}
+			}
+		}
+	}
+
+	const int rounds = 5;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		packet.check(soa, bvh);
+	}
+	double packetNs = nsSince(start, rounds);
+
+	HitTest single;
+	single.query = HitClosest;
+	vector<int> singleIds;
+	int mismatches = 0;
+
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		singleIds.clear();
+		for (const Line& l : packet.rays) {
+			single.line = l;
+			if (single.check(soa, bvh)) {
+				singleIds.push_back(single.hits.front().id);
+			}
+		}
+	}
+	double singleNs = nsSince(start, rounds);
+
+	// per ray distances have to be equal to the last bit, both use the same kernel
+	for (size_t r = 0; r < packet.rays.size(); ++r) {
+		single.line = packet.rays[r];
+		single.check(soa, bvh);
+		float t = single.hits.empty() ? FLT_MAX : single.hits.front().t;
+		mismatches += t == packet.closestT[r] ? 0 : 1;
+	}
+
+	sort(singleIds.begin(), singleIds.end());
+	singleIds.erase(unique(singleIds.begin(), singleIds.end()), singleIds.end());
+	mismatches += singleIds == packet.ids ? 0 : 1;
+
+	int rays = (int)packet.rays.size();
+	printf("packet %7i tris, %5i rays: packet %10.0f ns (%6.0f ns/ray), single rays %10.0f ns (%6.0f ns/ray), %4.1fx, ids %i, nodes %i, mismatches %i\n",
+		triangles, rays, packetNs, packetNs / rays, singleNs, singleNs / rays, singleNs / packetNs, (int)packet.ids.size(), packet.nodesVisited, mismatches);
+
+	return mismatches == 0;
+}
+
+// region selection against a brute force pass over all triangles, for a perspective and an ortho sub-frustum
+static bool benchFrustum(int triangles) {
+	mt19937 rng(triangles + 2);
+	vector<Triangle> scene = randomScene(triangles, rng);
+
+	BVH bvh;
+	bvh.build(scene);
+
+	M44F eye;
+	eye.Mult(M44F().asTranslate(1, 2, 25)).Mult(M44F().asRotateY(rad(10))).Mult(M44F().asRotateX(rad(-5)));
+
+	Frustum views[2] = {
+		Frustum::fromView(eye, true, -0.01f, 0.02f, -0.015f, 0.01f, 0.1f, 100),
+		Frustum::fromView(eye, false, -6, 3, -2, 5, 0.1f, 100),
+	};
+
+	bool ok = true;
+	for (const Frustum& f : views) {
+		bool perspective = &f == &views[0];
+		vector<int> ids;
+
+		const int rounds = 20;
+		int visited = 0;
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < rounds; ++i) {
+			visited = f.collectIds(bvh, scene, ids);
+		}
+		double bvhNs = nsSince(start, rounds);
+
+		vector<int> expected;
+		int mismatches = 0;
+		start = Clock::now();
+		for (const Triangle& t : scene) {
+			if (f.overlaps(t)) {
+				expected.push_back(t.id);
+			}
+		}
+		double bruteNs = nsSince(start, 1);
+
+		sort(expected.begin(), expected.end());
+		expected.erase(unique(expected.begin(), expected.end()), expected.end());
+		mismatches += ids == expected ? 0 : 1;
+
+		// independent of clipping: a vertex inside all planes means selected, all vertices behind one plane means not
+		for (const Triangle& t : scene) {
+			bool anyInside = false;
+			bool culled = false;
+			for (const Plane& p : f.planes) {
+				culled |= p.distance(t.vertices[0]) < 0 && p.distance(t.vertices[1]) < 0 && p.distance(t.vertices[2]) < 0;
+			}
+			for (const Vec3F& v : t.vertices) {
+				bool in = true;
+				for (const Plane& p : f.planes) {
+					in &= p.distance(v) > 0;
+				}
+				anyInside |= in;
+			}
+
+			bool selected = binary_search(ids.begin(), ids.end(), t.id);
+			mismatches += (anyInside && !selected) || (culled && f.overlaps(t)) ? 1 : 0;
+		}
+
+		printf("frustum %7i tris %s: bvh %10.0f ns, brute force %12.0f ns, %5.1fx, nodes %i, ids %i, mismatches %i\n",
+			triangles, perspective ? "perspective" : "ortho      ", bvhNs, bruteNs, bruteNs / bvhNs, visited, (int)ids.size(), mismatches);
+
+		ok &= mismatches == 0;
+	}
+
+	return ok;
+}
+
+static bool identicalHits(const HitTest& a, const HitTest& b) {
+	if (a.hits.size() != b.hits.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < a.hits.size(); ++i) {
+		const HitPosition& ha = a.hits[i];
+		const HitPosition& hb = b.hits[i];
+		if (ha.id != hb.id || ha.t != hb.t || ha.v.x != hb.v.x || ha.v.y != hb.v.y || ha.v.z != hb.v.z) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// linear check() spread over 1..N threads; every result has to equal the serial one exactly
+static bool benchThreads(int triangles) {
+	mt19937 rng(triangles + 3);
+	vector<Triangle> scene = randomScene(triangles, rng);
+	vector<Line> rays = randomRays(20, rng);
+
+	int mismatches = 0;
+	double serialNs[2] = {};
+	vector<HitTest> serial(rays.size() * 2);
+	for (size_t i = 0; i < serial.size(); ++i) {
+		HitTest& ht = serial[i];
+		ht.query = i % 2 ? HitClosest : HitAll;
+		ht.tris = scene;
+		ht.line = rays[i / 2];
+
+		Clock::time_point start = Clock::now();
+		ht.check();
+		serialNs[i % 2] += nsSince(start, (int)rays.size());
+	}
+
+	printf("threads %i tris, serial: all %.2f ms/ray, closest %.2f ms/ray, %i cores\n", triangles, serialNs[0] / 1e6, serialNs[1] / 1e6, ThreadPool::defaultSize());
+
+	int maxThreads = max(4, ThreadPool::defaultSize());
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		ThreadPool pool(threads);
+		double ns[2] = {};
+
+		HitTest parallel[2];
+		for (HitTest& ht : parallel) {
+			ht.tris = scene;
+		}
+		parallel[1].query = HitClosest;
+
+		for (size_t i = 0; i < serial.size(); ++i) {
+			HitTest& ht = parallel[i % 2];
+			ht.line = rays[i / 2];
+
+			Clock::time_point start = Clock::now();
+			ht.check(pool);
+			ns[i % 2] += nsSince(start, (int)rays.size());
+
+			mismatches += identicalHits(ht, serial[i]) ? 0 : 1;
+		}
+
+		printf("  %2i threads: all %.2f ms/ray (%4.2fx), closest %.2f ms/ray (%4.2fx)%s\n", threads, ns[0] / 1e6, serialNs[0] / ns[0], ns[1] / 1e6, serialNs[1] / ns[1],
+			threads > ThreadPool::defaultSize() ? ", more threads than cores" : "");
+	}
+
+	printf("  mismatches %i\n", mismatches);
+	return mismatches == 0;
+}
+
+// closed form TRS against the chain of Mult it replaced; rounding differs, so only closeness is checked
+static bool verifyTRS(int rounds) {
+	mt19937 rng(rounds);
+	uniform_real_distribution<float> any(-10, 10);
+	uniform_real_distribution<float> degrees(-360, 360);
+	float worst = 0;
+
+	for (int i = 0; i < rounds; ++i) {
+		CubeShape c;
+		c.pos = { any(rng), any(rng), any(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		c.scale = { any(rng), any(rng), any(rng) };
+
+		M44F chain;
+		chain.asTranslate(c.pos.x, c.pos.y, c.pos.z)
+			.Mult(M44F().asRotateZ(rad(c.angle.z)))
+			.Mult(M44F().asRotateX(rad(c.angle.x)))
+			.Mult(M44F().asRotateY(rad(c.angle.y)))
+			.Mult(M44F().asScale(c.scale.x, c.scale.y, c.scale.z));
+
+		M44F trs = c.modelMatrix();
+		for (int col = 0; col < 4; ++col) {
+			for (int row = 0; row < 4; ++row) {
+				worst = fmaxf(worst, fabsf(chain.m[col][row] - trs.m[col][row]));
+			}
+		}
+	}
+
+	// entries are up to |scale| = 10, float has ~7 digits
+	bool ok = worst < 1e-4f;
+	printf("trs: %i rounds, max difference to Mult chain %g%s\n", rounds, worst, ok ? "" : " - too big");
+	return ok;
+}
+
+// what meshShape did before the vertex pipeline: a Quad per face, each of 36 triangle corners transformed on its own
+static void meshShapeQuads(const CubeShape& c, const M44F& m, vector<Triangle>& fill) {
+	for (int i = 0; i < 6; ++i) {
+		Quad q(c.id, CubeShape::vertices.data(), CubeShape::facesIndices.data() + i * 4);
+		auto tris = q.asTris();
+		tris.first.transform(m);
+		tris.second.transform(m);
+		fill.push_back(tris.first);
+		fill.push_back(tris.second);
+	}
+}
+
+// vertex pipeline against per quad meshing; same triangles in the same order, equal to the last bit
+static bool verifyMeshPipeline(int rounds) {
+	mt19937 rng(rounds);
+	uniform_real_distribution<float> any(-10, 10);
+	uniform_real_distribution<float> degrees(-360, 360);
+	int mismatches = 0;
+	vector<Triangle> quads, pipeline;
+
+	for (int i = 0; i < rounds; ++i) {
+		CubeShape c;
+		c.id = i;
+		c.pos = { any(rng), any(rng), any(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		c.scale = { any(rng), any(rng), any(rng) };
+		M44F m = c.modelMatrix();
+
+		quads.clear();
+		pipeline.clear();
+		meshShapeQuads(c, m, quads);
+		c.meshShape(m, pipeline);
+
+		bool same = quads.size() == pipeline.size();
+		for (size_t t = 0; same && t < quads.size(); ++t) {
+			same = quads[t].id == pipeline[t].id && 0 == memcmp(quads[t].vertices, pipeline[t].vertices, sizeof(quads[t].vertices));
+		}
+		mismatches += same ? 0 : 1;
+	}
+
+	printf("mesh pipeline: %i cubes, mismatches against per quad meshing %i\n", rounds, mismatches);
+	return mismatches == 0;
+}
+
+// what pointerUpdateFreespace did before quaternions: 5 matrix chain, then back to angles through rotationYXZ
+static void freespaceTurnEuler(Camera& c, float oY, float oX) {
+	M44F m;
+	m.Mult(M44F().asRotateY(rad(c.angle.y)))
+		.Mult(M44F().asRotateX(rad(c.angle.x)))
+		.Mult(M44F().asRotateZ(rad(c.angle.z)))
+		.Mult(M44F().asRotateY(rad(oY)))
+		.Mult(M44F().asRotateX(rad(oX)));
+
+	Vec3F fwd = { 0,0,-1 };
+	Vec3F up = { 0,1,0 };
+	Vec3F r = m.ApplyOnPoint(fwd).rotationYXZ(m.ApplyOnPoint(up));
+	c.angle = { (float)deg(r.x), (float)deg(r.y), (float)deg(r.z) };
+}
+
+static void freespaceTurnQuat(Camera& c, float oY, float oX) {
+	c.setOrientationMode(OrientationQuat);
+	c.orientation.Mult(Quat::rotateY(rad(oY))).Mult(Quat::rotateX(rad(oX))).normalize();
+}
+
+static float maxDifference(const M44F& a, const M44F& b) {
+	float worst = 0;
+	for (int col = 0; col < 4; ++col) {
+		for (int row = 0; row < 4; ++row) {
+			worst = fmaxf(worst, fabsf(a.m[col][row] - b.m[col][row]));
+		}
+	}
+	return worst;
+}
+
+// Quat against the matrices it stands for in Camera and CubeShape, then a long run of freespace turns done both ways
+static bool verifyQuat(int rounds) {
+	mt19937 rng(rounds);
+	uniform_real_distribution<float> any(-10, 10);
+	uniform_real_distribution<float> degrees(-360, 360);
+	float worst = 0;
+
+	for (int i = 0; i < rounds; ++i) {
+		Camera c;
+		c.pos = { any(rng), any(rng), any(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		M44F euler = c.eyeMatrix();
+		c.setOrientationMode(OrientationQuat);
+		worst = fmaxf(worst, maxDifference(euler, c.eyeMatrix()));
+
+		Vec3F p = { any(rng), any(rng), any(rng) };
+		Vec3F a = euler.ApplyOnPoint(p), b = c.orientation.ApplyOnPoint(p);
+		b.add(c.pos);
+		worst = fmaxf(worst, fmaxf(fabsf(a.x - b.x), fmaxf(fabsf(a.y - b.y), fabsf(a.z - b.z))));
+
+		CubeShape s;
+		s.pos = c.pos;
+		s.angle = c.angle;
+		s.scale = { any(rng), any(rng), any(rng) };
+		euler = s.modelMatrix();
+		s.orientation = Quat::fromZXY({ (float)rad(s.angle.x), (float)rad(s.angle.y), (float)rad(s.angle.z) });
+		s.orientationMode = OrientationQuat;
+		worst = fmaxf(worst, maxDifference(euler, s.modelMatrix()));
+	}
+
+	// entries are up to |scale| = 10, points up to ~17 away
+	bool ok = worst < 1e-4f;
+	printf("quat: %i rounds, max difference to Euler matrices %g%s\n", rounds, worst, ok ? "" : " - too big");
+
+	// same mouse moves both ways; Euler loses roll when looking straight up or down, quaternion stays orthonormal
+	Camera euler, quat;
+	uniform_real_distribution<float> turn(-3, 3);
+	for (int i = 0; i < 1000000; ++i) {
+		float oY = turn(rng), oX = turn(rng);
+		freespaceTurnEuler(euler, oY, oX);
+		freespaceTurnQuat(quat, oY, oX);
+	}
+
+	M44F e = euler.eyeMatrix(), q = quat.eyeMatrix();
+	Vec3F fwd = q.ApplyOnPoint({ 0,0,-1 }), up = q.ApplyOnPoint({ 0,1,0 });
+	float skew = fabsf(fwd.x * up.x + fwd.y * up.y + fwd.z * up.z);
+	float stretch = fabsf(fwd.len() - 1);
+	printf("quat: 1000000 freespace turns, quaternion skew %g stretch %g, Euler and quaternion paths apart by %g\n",
+		skew, stretch, maxDifference(e, q));
+
+	return ok && skew < 1e-5f && stretch < 1e-5f;
+}
+
+// SIMD M44<float> paths against the scalar ones on random matrices and points; has to be equal to the last bit
+static bool verifyM44Simd(int rounds) {
+	mt19937 rng(rounds);
+	uniform_real_distribution<float> any(-10, 10);
+	int mismatches = 0;
+
+	for (int i = 0; i < rounds; ++i) {
+		M44F a, b;
+		for (int c = 0; c < 4; ++c) {
+			for (int r = 0; r < 4; ++r) {
+				a.m[c][r] = any(rng);
+				b.m[c][r] = any(rng);
+			}
+		}
+
+		M44F simd = a;
+		simd.Mult(b);
+		M44F scalar = a;
+		scalar.MultScalar(b);
+
+		// in place, with itself as the other side
+		M44F selfSimd = a;
+		selfSimd.Mult(selfSimd);
+		M44F selfScalar = a;
+		selfScalar.MultScalar(M44F(a));
+
+		for (int c = 0; c < 4; ++c) {
+			for (int r = 0; r < 4; ++r) {
+				mismatches += simd.m[c][r] == scalar.m[c][r] && selfSimd.m[c][r] == selfScalar.m[c][r] ? 0 : 1;
+			}
+		}
+
+		Vec3F points[7];
+		for (Vec3F& p : points) {
+			p = { any(rng), any(rng), any(rng) };
+		}
+
+		Vec3F batched[7];
+		a.ApplyOnPoints(points, batched, 7);
+		for (int p = 0; p < 7; ++p) {
+			Vec3F single = a.ApplyOnPoint(points[p]);
+			mismatches += single.x == batched[p].x && single.y == batched[p].y && single.z == batched[p].z ? 0 : 1;
+		}
+
+		// in place, as Triangle::transform does it
+		a.ApplyOnPoints(points, points, 7);
+		for (int p = 0; p < 7; ++p) {
+			mismatches += points[p].x == batched[p].x && points[p].y == batched[p].y && points[p].z == batched[p].z ? 0 : 1;
+		}
+	}
+
+	printf("m44 simd: %i rounds, mismatches %i\n", rounds, mismatches);
+	return mismatches == 0;
+}
+
+// stands in for ModelCube: 12 triangles around pos
+struct BenchBlob : public Renderable {
+	Vec3F pos;
+
+	void render(int) const {}
+	void toggleSelect() {}
+
+	void mesh(vector<Triangle>& fill) const {
+		for (int i = 0; i < 12; ++i) {
+			float a = (float)i;
+			Triangle t = { 0, { pos, pos, pos } };
+			t.vertices[1].add({ 0.2f * cosf(a), 0.2f * sinf(a), 0 });
+			t.vertices[2].add({ 0, 0.2f * cosf(a), 0.2f * sinf(a) });
+			fill.push_back(t);
+		}
+	}
+};
+
+static void benchSceneMesh(int objects) {
+	mt19937 rng(objects);
+	uniform_real_distribution<float> place(-20, 20);
+
+	vector<shared_ptr<Renderable>> renderables;
+	for (int i = 0; i < objects; ++i) {
+		shared_ptr<BenchBlob> b = make_shared<BenchBlob>();
+		b->pos = { place(rng), place(rng), place(rng) };
+		renderables.push_back(b);
+	}
+
+	SceneMesh sceneMesh;
+	Clock::time_point start = Clock::now();
+	sceneMesh.update(renderables);
+	double buildNs = nsSince(start, 1);
+
+	const int rounds = 200;
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		sceneMesh.update(renderables);
+	}
+	double cleanNs = nsSince(start, rounds);
+
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		BenchBlob* moved = (BenchBlob*)renderables[i % objects].get();
+		moved->pos.x += 0.01f;
+		moved->transformChanged();
+		sceneMesh.update(renderables);
+	}
+	double dirtyNs = nsSince(start, rounds);
+
+	vector<Line> rays = randomRays(rounds, rng);
+	vector<Triangle> remeshed;
+	HitTest ht;
+	start = Clock::now();
+	for (const Line& l : rays) {
+		// what cursorUpdate did before caching: mesh everything into a fresh vector, then test linearly
+		remeshed.clear();
+		for (const shared_ptr<Renderable>& each : renderables) {
+			each->mesh(remeshed);
+		}
+		ht.tris = remeshed;
+		ht.line = l;
+		ht.check();
+	}
+	double uncachedNs = nsSince(start, rounds);
+
+	ht.query = HitClosest;
+	start = Clock::now();
+	for (const Line& l : rays) {
+		sceneMesh.update(renderables);
+		ht.line = l;
+		ht.check(sceneMesh.soa, sceneMesh.bvh);
+	}
+	double cachedNs = nsSince(start, rounds);
+
+	printf("scene mesh %6i objects: initial %.2f ms, clean update %8.0f ns, one moved %10.0f ns, pick uncached %12.0f ns, pick cached %8.0f ns\n",
+		objects, buildNs / 1e6, cleanNs, dirtyNs, uncachedNs, cachedNs);
+}
+
+// CPU side of a frame of cubes: each transformed into the shared batch from its cached model matrix, every 10th selected
+static void benchCubeBatch(int objects) {
+	mt19937 rng(objects);
+	uniform_real_distribution<float> place(-20, 20);
+	uniform_real_distribution<float> degrees(-180, 180);
+
+	vector<M44F> models(objects);
+	for (M44F& m : models) {
+		CubeShape c;
+		c.pos = { place(rng), place(rng), place(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		c.scale = { 0.2f, 0.2f, 0.2f };
+		m = c.modelMatrix();
+	}
+
+	CubeBatch batch;
+	auto frame = [&]() {
+		batch.clear();
+		for (int i = 0; i < objects; ++i) {
+			batch.add(models[i], i % 10 == 0);
+		}
+	};
+
+	Clock::time_point start = Clock::now();
+	frame();
+	double firstNs = nsSince(start, 1);
+
+	const int rounds = 20;
+	long long allocated = allocations;
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		frame();
+	}
+	double frameNs = nsSince(start, rounds);
+	allocated = allocations - allocated;
+
+	printf("cube batch %6i cubes: first frame %.2f ms, next frames %.2f ms (%.1f ns/cube), %lli allocs, %i face indices, %i edge indices\n",
+		objects, firstNs / 1e6, frameNs / 1e6, frameNs / objects, allocated, batch.faceIndexCount(), (int)batch.edges.size());
+}
+
+// cube kept the way DrawPlane did before SceneStore: one heap object each, reached through shared_ptr and virtual calls
+struct BenchCube : public Renderable {
+	CubeShape shape;
+	M44F model;
+	bool wireframe = false;
+
+	void toggleSelect() {
+		wireframe = !wireframe;
+	}
+
+	void mesh(vector<Triangle>& fill) const {
+		shape.meshShape(model, fill);
+	}
+
+	void render(int) const {
+	}
+
+	bool addToBatch(CubeBatch& batch) const {
+		batch.add(model, wireframe);
+		return true;
+	}
+};
+
+// same cubes as shared_ptr<Renderable> and as SceneStore: frame preparation (batch), scene mesh upkeep and picking
+static bool benchSceneStore(int objects) {
+	mt19937 rng(objects);
+	uniform_real_distribution<float> place(-20, 20);
+	uniform_real_distribution<float> degrees(-180, 180);
+
+	vector<shared_ptr<Renderable>> renderables;
+	SceneStore store;
+	for (int i = 0; i < objects; ++i) {
+		CubeShape c;
+		c.pos = { place(rng), place(rng), place(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		c.scale = { 0.2f, 0.2f, 0.2f };
+		c.id = store.addCube(c);
+
+		shared_ptr<BenchCube> b = make_shared<BenchCube>();
+		b->shape = c;
+		b->model = c.modelMatrix();
+		renderables.push_back(b);
+	}
+
+	CubeBatch batch;
+	vector<const Renderable*> unbatched;
+	const int rounds = 20;
+
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		batch.clear();
+		for (const shared_ptr<Renderable>& each : renderables) {
+			each->addToBatch(batch);
+		}
+	}
+	double renderablesFrameNs = nsSince(start, rounds);
+
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		batch.clear();
+		unbatched.clear();
+		store.batch(batch, unbatched);
+	}
+	double storeFrameNs = nsSince(start, rounds);
+
+	SceneMesh byRenderables, byStore;
+	byRenderables.update(renderables);
+	byStore.update(store);
+
+	bool same = byRenderables.tris.size() == byStore.tris.size()
+		&& 0 == memcmp(byRenderables.tris.data(), byStore.tris.data(), byStore.tris.size() * sizeof(Triangle));
+
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		byRenderables.update(renderables);
+	}
+	double renderablesCleanNs = nsSince(start, rounds);
+
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		byStore.update(store);
+	}
+	double storeCleanNs = nsSince(start, rounds);
+
+	vector<Line> rays = randomRays(rounds, rng);
+	HitTest a, b;
+	a.query = b.query = HitClosest;
+	double renderablesPickNs = 0, storePickNs = 0;
+	int mismatches = 0;
+	for (int i = 0; i < rounds; ++i) {
+		Vec3F pos = { place(rng), place(rng), place(rng) };
+
+		BenchCube* moved = (BenchCube*)renderables[i].get();
+		start = Clock::now();
+		moved->shape.pos = pos;
+		moved->model = moved->shape.modelMatrix();
+		moved->transformChanged();
+		byRenderables.update(renderables);
+		a.line = rays[i];
+		a.check(byRenderables.soa, byRenderables.bvh);
+		renderablesPickNs += nsSince(start, 1);
+
+		start = Clock::now();
+		store.moveCube(i, pos);
+		byStore.update(store);
+		b.line = rays[i];
+		b.check(byStore.soa, byStore.bvh);
+		storePickNs += nsSince(start, 1);
+
+		mismatches += sameFirstHit(a, b) ? 0 : 1;
+	}
+
+	printf("scene store %6i cubes: frame prep renderables %.2f ms, store %.2f ms; mesh upkeep renderables %8.0f ns, store %8.0f ns; move + pick renderables %8.0f ns, store %8.0f ns, mismatches %i%s\n",
+		objects, renderablesFrameNs / 1e6, storeFrameNs / 1e6, renderablesCleanNs, storeCleanNs,
+		renderablesPickNs / rounds, storePickNs / rounds, mismatches, same ? "" : ", meshes differ");
+
+	return same && mismatches == 0;
+}
+
+// id lookup through slot map against linear scan it replaced; then half of the cubes removed and as many added, after
+// which every live id has to find its own cube and no removed id may find anything, and removal has to stay cheap with
+// all of them in the same grid cells; and a slot map filled up
+static bool benchIdLookup(int objects) {
+	mt19937 rng(objects);
+	SceneStore store;
+	vector<int> created;
+	for (int i = 0; i < objects; ++i) {
+		created.push_back(store.addCube(CubeShape()));
+	}
+
+	vector<int> lookups(1024);
+	for (int& id : lookups) {
+		id = created[rng() % objects];
+	}
+
+	const int rounds = 1000;
+	int found = 0;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		int id = lookups[i & 1023];
+		for (int c = 0; c < store.cubeCount(); ++c) {
+			if (store.ids[c] == id) {
+				found += c;
+				break;
+			}
+		}
+	}
+	double linearNs = nsSince(start, rounds);
+
+	start = Clock::now();
+	for (int i = 0; i < rounds * 1000; ++i) {
+		found += store.cubeForId(lookups[i & 1023]);
+	}
+	double slotNs = nsSince(start, rounds * 1000);
+	sink = (float)found;
+
+	shuffle(created.begin(), created.end(), rng);
+	vector<int> removed(created.begin(), created.begin() + objects / 2);
+	vector<int> live(created.begin() + objects / 2, created.end());
+
+	start = Clock::now();
+	for (int id : removed) {
+		store.remove(id);
+	}
+	double removeNs = nsSince(start, (int)removed.size());
+
+	for (int i = 0; i < objects / 2; ++i) {
+		live.push_back(store.addCube(CubeShape()));
+	}
+
+	int wrong = 0;
+	for (int id : live) {
+		int c = store.cubeForId(id);
+		wrong += c >= 0 && store.ids[c] == id && store.shapes[c].id == id ? 0 : 1;
+	}
+	for (int id : removed) {
+		wrong += store.cubeForId(id) == -1 ? 0 : 1;
+	}
+
+	sort(live.begin(), live.end());
+	wrong += (int)(live.end() - unique(live.begin(), live.end()));
+
+	// ids run out at MAX_SLOTS rather than wrapping onto slot 0
+	SlotMap<int> full;
+	for (int i = 0; i < SlotMap<int>::MAX_SLOTS; ++i) {
+		wrong += full.insert(i) > 0 ? 0 : 1;
+	}
+	wrong += full.insert(0) == -1 ? 0 : 1;
+
+	// all cubes share the same cells; removal costs the cells of one cube, never a scan of everyone listed in them,
+	// which took hundreds of us here
+	const double REMOVE_LIMIT_NS = 50000;
+	bool removeFast = removeNs < REMOVE_LIMIT_NS;
+
+	printf("id lookup %6i cubes: linear %10.1f ns, slot map %6.1f ns, remove %6.1f ns%s, wrong %i\n",
+		objects, linearNs, slotNs, removeNs, removeFast ? "" : " (too slow)", wrong);
+	return wrong == 0 && removeFast;
+}
+
+static vector<int> sortedIds(const HitTest& ht) {
+	vector<int> ids;
+	for (const HitPosition& h : ht.hits) {
+		ids.push_back(h.id);
+	}
+	sort(ids.begin(), ids.end());
+	return ids;
+}
+
+// grid queries against scene mesh bvh (rays) and against testing every box (frustum, box), before and after moving
+// a part of the cubes around and removing another part
+static bool benchSpatialGrid(int objects) {
+	mt19937 rng(objects);
+	uniform_real_distribution<float> place(-20, 20);
+	uniform_real_distribution<float> degrees(-180, 180);
+
+	SceneStore store;
+	for (int i = 0; i < objects; ++i) {
+		CubeShape c;
+		c.pos = { place(rng), place(rng), place(rng) };
+		c.angle = { degrees(rng), degrees(rng), degrees(rng) };
+		c.scale = { 0.2f, 0.2f, 0.2f };
+		store.addCube(c);
+	}
+
+	SceneMesh sceneMesh;
+	vector<Line> rays = randomRays(200, rng);
+	HitTest byGrid, byBvh;
+	auto meshOf = [&](int id, vector<Triangle>& tris) {
+		store.meshObject(id, tris);
+	};
+
+	Camera view;
+	view.pos = { 0, 0, 30 };
+	view.viewSize = { 800, 600 };
+	view.nearPlane = 0.1f;
+	view.farPlane = 40;
+	ClippingRange r = view.calculateClippingRange();
+	Frustum f = Frustum::fromView(view.eyeMatrix(), true, r.left * 0.5f, r.right * 0.5f, r.bottom * 0.5f, r.top * 0.5f, view.nearPlane, view.farPlane);
+
+	// zoomed in, ends inside the scene; answered from cells rather than by testing every box
+	Frustum narrow = Frustum::fromView(view.eyeMatrix(), true, r.left * 0.05f, r.right * 0.05f, r.bottom * 0.05f, r.top * 0.05f, view.nearPlane, 25);
+
+	AABB probe;
+	probe.lo = { -3, -3, -3 };
+	probe.hi = { 3, 3, 3 };
+
+	double gridPickNs = 0, bvhPickNs = 0, gridFrustumNs = 0, allFrustumNs = 0, gridNarrowNs = 0, allNarrowNs = 0, moveNs = 0;
+	int mismatches = 0, visible = 0;
+	vector<int> ids, expected, removedIds;
+
+	for (int pass = 0; pass < 2; ++pass) {
+		for (const Line& l : rays) {
+			byGrid.line = byBvh.line = l;
+			byGrid.query = byBvh.query = HitClosest;
+
+			Clock::time_point start = Clock::now();
+			byGrid.check(store.grid, meshOf);
+			gridPickNs += nsSince(start, 1);
+
+			start = Clock::now();
+			sceneMesh.update(store);
+			byBvh.check(sceneMesh.soa, sceneMesh.bvh);
+			bvhPickNs += nsSince(start, 1);
+
+			mismatches += sameFirstHit(byGrid, byBvh) ? 0 : 1;
+
+			byGrid.query = byBvh.query = HitAll;
+			byGrid.check(store.grid, meshOf);
+			byBvh.check(sceneMesh.soa, sceneMesh.bvh);
+			mismatches += sortedIds(byGrid) == sortedIds(byBvh) ? 0 : 1;
+		}
+
+		Clock::time_point start = Clock::now();
+		store.grid.queryFrustum(f, ids);
+		gridFrustumNs += nsSince(start, 1);
+
+		start = Clock::now();
+		expected.clear();
+		for (int i = 0; i < store.cubeCount(); ++i) {
+			if (f.classify(CubeShape::boundsOf(store.models[i])) != FrustumOutside) {
+				expected.push_back(store.ids[i]);
+			}
+		}
+		sort(expected.begin(), expected.end());
+		allFrustumNs += nsSince(start, 1);
+		mismatches += ids == expected ? 0 : 1;
+		visible = (int)ids.size();
+
+		start = Clock::now();
+		store.grid.queryFrustum(narrow, ids);
+		gridNarrowNs += nsSince(start, 1);
+
+		start = Clock::now();
+		expected.clear();
+		for (int i = 0; i < store.cubeCount(); ++i) {
+			if (narrow.classify(CubeShape::boundsOf(store.models[i])) != FrustumOutside) {
+				expected.push_back(store.ids[i]);
+			}
+		}
+		sort(expected.begin(), expected.end());
+		allNarrowNs += nsSince(start, 1);
+		mismatches += ids == expected ? 0 : 1;
+
+		store.grid.queryBox(probe, ids);
+		expected.clear();
+		for (int i = 0; i < store.cubeCount(); ++i) {
+			AABB b = CubeShape::boundsOf(store.models[i]);
+			if (b.lo.x <= probe.hi.x && b.hi.x >= probe.lo.x && b.lo.y <= probe.hi.y && b.hi.y >= probe.lo.y && b.lo.z <= probe.hi.z && b.hi.z >= probe.lo.z) {
+				expected.push_back(store.ids[i]);
+			}
+		}
+		sort(expected.begin(), expected.end());
+		mismatches += ids == expected ? 0 : 1;
+
+		// a tenth of the cubes moves for the second pass
+		start = Clock::now();
+		for (int i = 0; i < objects / 10; ++i) {
+			store.moveCube(i * 10, { place(rng), place(rng), place(rng) });
+		}
+		moveNs = nsSince(start, objects / 10);
+
+		// and another tenth is removed, which moves entries around in grid and in the lists of their cells
+		removedIds.clear();
+		for (int i = 0; i < objects / 10; ++i) {
+			removedIds.push_back(store.ids[i * 10 + 5]);
+		}
+		for (int id : removedIds) {
+			store.remove(id);
+		}
+	}
+
+	// empty box (mesh without triangles) is in no query, one far too big for cells is in every one that reaches it;
+	// either may turn into an ordinary box and back
+	SpatialGrid odd;
+	AABB huge;
+	huge.lo = { -1e30f, -1e30f, -1e30f };
+	huge.hi = { 1e30f, 1e30f, 1e30f };
+	AABB unit;
+	unit.lo = { 0, 0, 0 };
+	unit.hi = { 1, 1, 1 };
+	AABB nan = unit;
+	nan.hi.y = NAN;
+
+	odd.insert(1, AABB());
+	odd.insert(2, huge);
+	odd.insert(3, unit);
+	odd.insert(4, nan);
+
+	vector<int> hugeAndUnit = { 2, 3 };
+	vector<int> walked;
+	odd.queryBox(probe, ids);
+	mismatches += ids == hugeAndUnit ? 0 : 1;
+	odd.queryFrustum(f, ids);
+	mismatches += ids == hugeAndUnit ? 0 : 1;
+	odd.walkRay({ 0.5f, 0.5f, -5 }, { 0, 0, 1 }, [&](const vector<int>& cellIds, float, float) {
+		walked.insert(walked.end(), cellIds.begin(), cellIds.end());
+		return true;
+	});
+	sort(walked.begin(), walked.end());
+	mismatches += walked == hugeAndUnit ? 0 : 1;
+
+	odd.move(2, unit);
+	odd.move(1, huge);
+	odd.remove(3);
+	odd.queryBox(probe, ids);
+	mismatches += ids == vector<int>{ 1, 2 } ? 0 : 1;
+	odd.move(1, AABB());
+	odd.remove(4);
+	odd.queryBox(probe, ids);
+	mismatches += ids == vector<int>{ 2 } && odd.large.empty() && odd.size() == 2 ? 0 : 1;
+
+	int picks = (int)rays.size() * 2;
+	printf("spatial grid %6i cubes: pick grid %8.0f ns, scene mesh %8.0f ns; frustum (%i visible) grid %.2f ms, all boxes %.2f ms; zoomed in grid %.3f ms, all boxes %.2f ms; move %.0f ns, cells %i, mismatches %i\n",
+		objects, gridPickNs / picks, bvhPickNs / picks, visible, gridFrustumNs / 2e6, allFrustumNs / 2e6, gridNarrowNs / 2e6, allNarrowNs / 2e6, moveNs, (int)store.grid.cells.size(), mismatches);
+
+	return mismatches == 0;
+}
+
+// eye space point inside of what glFrustum / glOrtho with these extents keeps; margin m away from every side
+static bool insideProjection(const Camera& c, const Vec3F& e, float m) {
+	ClippingRange r = c.calculateClippingRange();
+	float depth = -e.z;
+	if (depth < c.nearPlane + m || depth > c.farPlane - m) {
+		return false;
+	}
+
+	float scale = c.perspective ? depth / c.nearPlane : 1;
+	return e.x > r.left * scale + m && e.x < r.right * scale - m && e.y > r.bottom * scale + m && e.y < r.top * scale - m;
+}
+
+// Camera::viewFrustum against projection extents, for perspective and ortho views as in multi view; then how much of
+// a scene each view culls, grid query against testing every box
+static bool benchViewCulling(int objects) {
+	mt19937 rng(objects);
+	uniform_real_distribution<float> place(-20, 20);
+
+	Camera views[4];
+	views[0].pos = { 0, 2, 15 };
+	views[0].angle = { -10, 20, 0 };
+	for (int i = 1; i < 4; ++i) {
+		views[i].perspective = false;
+		views[i].adjustOrtho = true;
+		views[i].orthoRange = { -5,5,-5,5 };
+		views[i].farPlane = 100;
+		views[i].nearPlane = -100;
+	}
+	views[1].angle = { -90,0,0 };
+	views[3].angle = { 0,-90,0 };
+	const char* names[4] = { "perspective", "ortho XZ", "ortho XY", "ortho ZY" };
+
+	int mismatches = 0;
+	for (Camera& c : views) {
+		c.viewSize = { 640, 360 };
+		Frustum f = c.viewFrustum();
+		M44F eyeToWorld = c.eyeMatrix();
+
+		uniform_real_distribution<float> eyeXY(-15, 15);
+		uniform_real_distribution<float> eyeZ(-120, 20);
+		for (int i = 0; i < 10000; ++i) {
+			Vec3F e = { eyeXY(rng), eyeXY(rng), eyeZ(rng) };
+			bool inside = insideProjection(c, e, 1e-3f);
+			bool outside = !insideProjection(c, e, -1e-3f);
+			if (!inside && !outside) {
+				continue;
+			}
+
+			AABB point;
+			point.grow(eyeToWorld.ApplyOnPoint(e));
+			bool kept = f.classify(point) != FrustumOutside;
+			mismatches += kept == inside ? 0 : 1;
+		}
+	}
+
+	SceneStore store;
+	for (int i = 0; i < objects; ++i) {
+		CubeShape c;
+		c.pos = { place(rng), place(rng), place(rng) };
+		c.scale = { 0.2f, 0.2f, 0.2f };
+		store.addCube(c);
+	}
+
+	vector<int> ids, expected;
+	printf("view culling %6i cubes:", objects);
+	for (int v = 0; v < 4; ++v) {
+		Clock::time_point start = Clock::now();
+		store.grid.queryFrustum(views[v].viewFrustum(), ids);
+		double gridMs = nsSince(start, 1) / 1e6;
+
+		Frustum f = views[v].viewFrustum();
+		expected.clear();
+		for (int i = 0; i < store.cubeCount(); ++i) {
+			if (f.classify(CubeShape::boundsOf(store.models[i])) != FrustumOutside) {
+				expected.push_back(store.ids[i]);
+			}
+		}
+		sort(expected.begin(), expected.end());
+		mismatches += ids == expected ? 0 : 1;
+
+		printf(" %s %i/%i culled in %.2f ms;", names[v], objects - (int)ids.size(), objects, gridMs);
+	}
+	printf(" mismatches %i\n", mismatches);
+
+	return mismatches == 0;
+}
+
+// lines and frustums of window rectangles, as rectangle selection uses them, in views placed as by multi view: a
+// line's middle lies in the frustum of a rectangle around its pixel and outside of one beside it; sample counts follow
+// the rectangle whatever the step, and a step of nothing gives no lines
+static bool benchPixelMapping() {
+	const float windowHeight = 720;
+
+	Camera views[2];
+	views[0].pos = { 0, 2, 15 };
+	views[0].angle = { -10, 20, 0 };
+	views[0].viewPos = { 0, 360 };		// top left
+	views[1].perspective = false;
+	views[1].adjustOrtho = true;
+	views[1].orthoRange = { -5,5,-5,5 };
+	views[1].farPlane = 100;
+	views[1].nearPlane = -100;
+	views[1].angle = { -90,0,0 };
+	views[1].viewPos = { 640, 0 };		// bottom right
+
+	int mismatches = 0;
+	int checked = 0;
+	vector<Line> lines;
+	for (Camera& c : views) {
+		c.viewSize = { 640, 360 };
+		float left = c.viewPos.x + 100;
+		float top = windowHeight - c.viewPos.y - c.viewSize.y + 50;
+
+		// corners either way round
+		c.linesInRect({ left + 100, top + 80 }, { left, top }, 4, windowHeight, lines);
+		mismatches += lines.size() == 26 * 21 ? 0 : 1;
+
+		Frustum around = c.frustumInRect({ left - 1, top - 1 }, { left + 101, top + 81 }, windowHeight);
+		Frustum beside = c.frustumInRect({ left + 103, top }, { left + 200, top + 80 }, windowHeight);
+		for (const Line& l : lines) {
+			Vec3F middle = l.second;
+			middle.sub(l.first).mult(0.5f).add(l.first);
+
+			AABB point;
+			point.grow(middle);
+			mismatches += around.classify(point) != FrustumOutside ? 0 : 1;
+			mismatches += beside.classify(point) == FrustumOutside ? 0 : 1;
+			++checked;
+		}
+
+		// below a pixel it is one line a pixel, not a loop that never gets across
+		c.linesInRect({ left, top }, { left + 10, top + 10 }, 1e-9f, windowHeight, lines);
+		mismatches += lines.size() == 11 * 11 ? 0 : 1;
+
+		// clipped to the view
+		c.linesInRect({ left - 1000, top }, { left, top }, 10, windowHeight, lines);
+		mismatches += lines.size() == 11 ? 0 : 1;
+
+		float steps[3] = { 0, -1, NAN };
+		for (float step : steps) {
+			c.linesInRect({ left, top }, { left + 10, top + 10 }, step, windowHeight, lines);
+			mismatches += lines.empty() ? 0 : 1;
+		}
+	}
+
+	printf("pixel mapping: %i lines in rectangle frustums, mismatches %i\n", checked, mismatches);
+	return mismatches == 0;
+}
+
+// what TextLayout::charCoord did before the glyph table: walk the font map up to the character
+static void charCoordScan(const char c, int& x, int& y) {
+	x = 0;
+	y = 0;
+	for (const char* each = FONT_MAP; *each; ++each) {
+		if (*each == c) {
+			return;
+		}
+		if (*each == '\n') {
+			y += 1;
+			x = 0;
+		}
+		else {
+			x += 1;
+		}
+	}
+
+	--x;
+}
+
+// texture coordinates of every glyph in a screen of log lines, scanning the font map against the glyph table
+static bool benchTextLayout(int lines) {
+	TextLayout layout;
+	layout.setCharSize(9, 18);
+
+	int mismatches = 0;
+	for (int c = 0; c < 256; ++c) {
+		int sx, sy, tx, ty;
+		charCoordScan((char)c, sx, sy);
+		layout.charCoord((char)c, tx, ty);
+		mismatches += sx == tx && sy == ty ? 0 : 1;
+	}
+
+	mt19937 rng(lines);
+	uniform_int_distribution<int> printable(32, 126);
+	string text;
+	for (int l = 0; l < lines; ++l) {
+		for (int i = 0; i < 80; ++i) {
+			text.push_back((char)printable(rng));
+		}
+		text.push_back('\n');
+	}
+
+	const int rounds = 20;
+	float tUnit = 1.0f / layout.TEXTURE_SIZE;
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < rounds; ++r) {
+		float sum = 0;
+		for (const char c : text) {
+			int x, y;
+			charCoordScan(c, x, y);
+			sum += x * layout.fontCharWidth * tUnit + y * layout.fontCharHeight * tUnit;
+		}
+		sink = sum;
+	}
+	double scanNs = nsSince(start, rounds * (int)text.size());
+
+	start = Clock::now();
+	for (int r = 0; r < rounds; ++r) {
+		float sum = 0;
+		for (const char c : text) {
+			sum += layout.glyph(c).x + layout.glyph(c).y;
+		}
+		sink = sum;
+	}
+	double tableNs = nsSince(start, rounds * (int)text.size());
+
+	printf("text layout %5i lines: scan %7.2f Mglyphs/s, table %8.2f Mglyphs/s, mismatches %i\n",
+		lines, 1e3 / scanNs, 1e3 / tableNs, mismatches);
+
+	return mismatches == 0;
+}
+
+// overlay of a frame: button labels and log lines, laid out from scratch each frame, then taken from TextMeshCache
+static bool benchTextMesh(int lines) {
+	TextLayout layout;
+	layout.setCharSize(9, 18);
+	UIFillRGB color = { { 150, 150, 250 }, { 200, 200, 250 } };
+
+	mt19937 rng(lines);
+	uniform_int_distribution<int> printable(32, 126);
+	vector<string> texts = { "Single view", "Multi view", "Reset camera", "Display coords", "Cursor", "Hit test" };
+	for (int l = 0; l < lines; ++l) {
+		string line = "line\t";
+		for (int i = 0; i < 60; ++i) {
+			line.push_back((char)printable(rng));
+		}
+		texts.push_back(line);
+	}
+
+	TextMeshCache cache;
+	int mismatches = 0;
+	for (const string& t : texts) {
+		TextMesh fresh;
+		fresh.build(layout, t, color);
+		const TextMesh& cached = cache.get(layout, t, color);
+		mismatches += fresh.size() == cached.size() && memcmp(fresh.vertices.data(), cached.vertices.data(), fresh.size() * sizeof(TextVertex)) == 0 ? 0 : 1;
+	}
+	cache.endFrame();
+
+	const int rounds = 200;
+	int vertices = 0;
+	TextMesh mesh;
+	long long allocated = allocations;
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < rounds; ++r) {
+		for (const string& t : texts) {
+			mesh.build(layout, t, color);
+			vertices += mesh.size();
+		}
+	}
+	double buildNs = nsSince(start, rounds);
+	double buildAllocs = (double)(allocations - allocated) / rounds;
+
+	allocated = allocations;
+	start = Clock::now();
+	for (int r = 0; r < rounds; ++r) {
+		for (const string& t : texts) {
+			vertices += cache.get(layout, t, color).size();
+		}
+		cache.endFrame();
+	}
+	double cachedNs = nsSince(start, rounds);
+	double cachedAllocs = (double)(allocations - allocated) / rounds;
+	sink = (float)vertices;
+
+	// a line scrolled away is dropped at end of the next frame
+	cache.get(layout, texts[0], color);
+	cache.endFrame();
+	mismatches += cache.meshes.size() == 1 ? 0 : 1;
+
+	printf("text mesh %4i strings: layout every frame %8.0f ns (%.1f allocs), cached %7.0f ns (%.1f allocs), mismatches %i\n",
+		(int)texts.size(), buildNs, buildAllocs, cachedNs, cachedAllocs, mismatches);
+
+	return mismatches == 0;
+}
+
+// a frame of overlay as renderOverlay2D collects it: buttons of mainUI and log lines, from cached text meshes; draw
+// calls it costs against what glBegin/glEnd per rectangle and per glyph did
+static bool benchOverlay(int lines) {
+	TextLayout layout;
+	layout.setCharSize(9, 18);
+	TextMeshCache meshes;
+	UIFillRGB white = { { 255,255,255 }, {180,180,180} };
+
+	UIRGBConfig colors;
+	colors.background = { {10,10,200}, {30,30,250} };
+	colors.border = { {50,50,250}, {20,20,200} };
+	colors.textColor = { { 150, 150, 250 }, { 200, 200, 250 } };
+
+	vector<UIRect> buttons(6);
+	const char* names[6] = { "Single view", "Multi view", "Reset camera", "Display coords", "Cursor", "Hit test" };
+	for (int i = 0; i < 6; ++i) {
+		buttons[i].text = names[i];
+		buttons[i].pos = { 0, i * 40.0f };
+		buttons[i].size = { 150, 30 };
+		buttons[i].currentState = &colors;
+		buttons[i].centerText(layout);
+	}
+
+	vector<string> log(lines);
+	for (int l = 0; l < lines; ++l) {
+		log[l] = "[" + to_string(l) + "] cursor at 0.25 1.50 -3.00, id " + to_string(l * 7);
+	}
+
+	OverlayBatch overlay;
+	auto frame = [&]() {
+		overlay.clear();
+		for (const UIRect& b : buttons) {
+			overlay.addQuad(b.pos.x, b.pos.y, b.size.x, b.size.y, b.currentState->background);
+			overlay.addFrame(b.pos.x, b.pos.y, b.size.x, b.size.y, b.currentState->border);
+			overlay.addText(meshes.get(layout, b.text, b.currentState->textColor), b.pos.x + b.textPos.x, b.pos.y + b.textPos.y);
+		}
+		for (int l = 0; l < lines; ++l) {
+			overlay.addText(meshes.get(layout, log[l], white), 0, l * 20.0f);
+		}
+		overlay.finish();
+		meshes.endFrame();
+	};
+
+	frame();
+	const int rounds = 200;
+	long long allocated = allocations;
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < rounds; ++r) {
+		frame();
+	}
+	double frameNs = nsSince(start, rounds);
+	allocated = allocations - allocated;
+
+	int glyphs = 0;
+	for (const UIRect& b : buttons) {
+		glyphs += (int)(b.text.size() - count(b.text.begin(), b.text.end(), ' '));
+	}
+	for (const string& l : log) {
+		glyphs += (int)(l.size() - count(l.begin(), l.end(), ' '));
+	}
+
+	int batchedDraws = 0;
+	for (int k = 0; k < OverlayBatch::OVERLAY_KINDS; ++k) {
+		batchedDraws += overlay.count[k] > 0 ? 1 : 0;
+	}
+	int mismatches = overlay.count[OverlayBatch::OverlayGlyphs] == glyphs * 4 ? 0 : 1;
+	mismatches += overlay.count[OverlayBatch::OverlayFill] == 6 * 4 && overlay.count[OverlayBatch::OverlayLines] == 6 * 8 ? 0 : 1;
+
+	printf("overlay %3i lines: collect %7.0f ns/frame, %lli allocs, %i vertices; draws %i (immediate mode %i), texture toggles 2 (immediate mode %i), mismatches %i\n",
+		lines, frameNs, allocated, overlay.size(), batchedDraws, 6 * 2 + glyphs, 6 * 2, mismatches);
+
+	return mismatches == 0;
+}
+
+// what MessageLog::printf did before the ring: format into a member buffer, then a list node and a string per line
+struct ListLog {
+	list<string> history;
+	char buffer[120] = {};
+
+	void printf(const char* format, int a, int b) {
+		snprintf(buffer, sizeof(buffer), format, a, b);
+		history.push_back(buffer);
+	}
+};
+
+// lines flushed into file at path, with those a note says were overwritten; lines failing check are mismatches
+template <typename C> static long long linesInLogFile(const string& path, C check, int& mismatches) {
+	long long lines = 0;
+	FILE* f = fopen(path.c_str(), "r");
+	char buffer[256];
+	while (f && fgets(buffer, sizeof(buffer), f)) {
+		long long lost = 0;
+		if (sscanf(buffer, "[log] %lli lines overwritten", &lost) == 1) {
+			lines += lost;
+		}
+		else if (strncmp(buffer, "[log] line overwritten", 22) == 0) {
+			lines += 1;
+		}
+		else {
+			lines += 1;
+			buffer[strcspn(buffer, "\n")] = 0;
+			mismatches += check(buffer) ? 0 : 1;
+		}
+	}
+	if (f) {
+		fclose(f);
+	}
+
+	return lines;
+}
+
+#ifdef EXPLORER3D_TEST_HOOKS
+// writer of line 0 stops after claiming its slot, until told to go on
+static atomic<int> stallState(0);	// 1 stalled, 2 go on
+
+static void stallLineZero(long long n) {
+	if (n != 0) {
+		return;
+	}
+
+	stallState = 1;
+	while (stallState != 2) {
+		this_thread::yield();
+	}
+}
+
+// one producer stalled between claiming a slot and copying its line while others lap the ring several times; nobody
+// may publish into that slot meanwhile, so readers never see a torn line and the stalled line still reaches the file.
+// Lines dropped on that slot are in the overwritten notes, so the file accounts for every line exactly
+static bool benchLogStalled(int producers) {
+	MessageLog log;
+	log.echo = false;
+	log.claimedHook = stallLineZero;
+
+	string path = "bench_log_stalled.txt";
+	int mismatches = log.spillTo(path.c_str()) ? 0 : 1;
+
+	bool stalledSeen = false;
+	auto check = [&](const string& line) {
+		if (line == "stalled producer line") {
+			stalledSeen = true;
+			return true;
+		}
+		int t, i, sum;
+		return sscanf(line.c_str(), "t%i line %i sum %i", &t, &i, &sum) == 3 && sum == t * 100003 + i;
+	};
+
+	stallState = 0;
+	thread stalled([&]() {
+		log.printf("stalled producer line\n");
+	});
+	while (stallState != 1) {
+		this_thread::yield();
+	}
+
+	atomic<bool> running(true);
+	int torn = 0;
+	thread reader([&]() {
+		vector<string> lines;
+		while (running) {
+			int found = log.last(MessageLog::CAPACITY, lines);
+			for (int i = 0; i < found; ++i) {
+				torn += check(lines[i]) ? 0 : 1;
+			}
+			log.flush();
+		}
+	});
+
+	const int linesEach = 3 * MessageLog::CAPACITY;
+	vector<thread> writers;
+	for (int t = 0; t < producers; ++t) {
+		writers.emplace_back([&, t]() {
+			for (int i = 0; i < linesEach; ++i) {
+				log.printf("t%i line %i sum %i\n", t, i, t * 100003 + i);
+			}
+		});
+	}
+	for (thread& w : writers) {
+		w.join();
+	}
+
+	stallState = 2;
+	stalled.join();
+	running = false;
+	reader.join();
+	log.flush();
+
+	stalledSeen = false;
+	long long inFile = linesInLogFile(path, check, mismatches);
+	remove(path.c_str());
+	mismatches += torn;
+	mismatches += stalledSeen && inFile == (long long)producers * linesEach + 1 ? 0 : 1;
+
+	printf("log stalled writer: %i producers x %i lines past it, torn reads %i, stalled line in file %s, mismatches %i\n",
+		producers, linesEach, torn, stalledSeen ? "yes" : "no", mismatches);
+
+	return mismatches == 0;
+}
+#endif
+
+// producers logging lines that carry their own checksum while render thread reads the newest ones, then everything
+// spilled to a file; torn or lost lines are mismatches
+static bool benchLog(int producers, int linesEach) {
+	MessageLog log;
+	log.echo = false;
+
+	string path = "bench_log_spill.txt";
+	bool opened = log.spillTo(path.c_str());
+
+	const int rounds = 100000;
+	ListLog listLog;
+	long long allocated = allocations;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		listLog.printf("cursor at %i, id %i\n", i, i * 7);
+	}
+	double listNs = nsSince(start, rounds);
+	double listAllocs = (double)(allocations - allocated) / rounds;
+
+	MessageLog single;
+	single.echo = false;
+	allocated = allocations;
+	start = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		single.printf("cursor at %i, id %i\n", i, i * 7);
+	}
+	double ringNs = nsSince(start, rounds);
+	double ringAllocs = (double)(allocations - allocated) / rounds;
+
+	atomic<bool> running(true);
+	int mismatches = 0;
+	int reads = 0;
+	auto check = [&](const string& line) {
+		int t, i, sum;
+		return sscanf(line.c_str(), "t%i line %i sum %i", &t, &i, &sum) == 3 && sum == t * 100003 + i;
+	};
+
+	// reader spills as the render loop does; ring is small against what is logged, so some lines are overwritten first
+	thread reader([&]() {
+		vector<string> lines;
+		while (running) {
+			int found = log.last(MessageLog::MAX_UNREAD, lines);
+			for (int i = 0; i < found; ++i) {
+				mismatches += check(lines[i]) ? 0 : 1;
+			}
+			++reads;
+			log.flush();
+		}
+	});
+
+	start = Clock::now();
+	vector<thread> writers;
+	for (int t = 0; t < producers; ++t) {
+		writers.emplace_back([&, t]() {
+			for (int i = 0; i < linesEach; ++i) {
+				log.printf("t%i line %i sum %i\n", t, i, t * 100003 + i);
+			}
+		});
+	}
+	for (thread& w : writers) {
+		w.join();
+	}
+	double parallelNs = nsSince(start, producers * linesEach);
+
+	running = false;
+	reader.join();
+	log.flush();
+
+	// every line is in the file, or counted in a note about overwritten ones
+	long long inFile = linesInLogFile(path, check, mismatches);
+	remove(path.c_str());
+	mismatches += opened && inFile == (long long)producers * linesEach ? 0 : 1;
+
+	printf("log: list %6.1f ns/line (%.2f allocs), ring %6.1f ns/line (%.2f allocs); %i producers %6.1f ns/line, %i reads, mismatches %i\n",
+		listNs, listAllocs, ringNs, ringAllocs, producers, parallelNs, reads, mismatches);
+
+	return mismatches == 0;
+}
+
+// caller side of logging a pick with a matrix in it: 4 lines written out on the calling thread as printf did with
+// std::cout, against the ring with writer thread flushing to file; and LOG_DEBUG as built by default
+static bool benchLogSink(int picks) {
+	int mismatches = 0;
+	auto check = [&](const string& line) {
+		float a, b, c, d;
+		return sscanf(line.c_str(), "[ %f %f %f %f ]", &a, &b, &c, &d) == 4;
+	};
+
+	M44F m;
+	auto latency = [&](vector<double>& samples, double q) {
+		sort(samples.begin(), samples.end());
+		return samples[(size_t)(q * (samples.size() - 1))];
+	};
+
+	string syncPath = "bench_log_sync.txt";
+	FILE* sync = fopen(syncPath.c_str(), "w");
+	vector<double> syncNs(picks);
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < picks && sync; ++i) {
+		Clock::time_point call = Clock::now();
+		for (int row = 0; row < 4; ++row) {
+			fprintf(sync, "[ %f\t%f\t%f\t%f ]\n", m.m[0][row], m.m[1][row], m.m[2][row], (float)i);
+			fflush(sync);
+		}
+		syncNs[i] = nsSince(call, 1);
+	}
+	double syncTotalNs = nsSince(start, picks);
+	if (sync) {
+		fclose(sync);
+	}
+	remove(syncPath.c_str());
+
+	string asyncPath = "bench_log_async.txt";
+	long long lines = 0;
+	vector<double> asyncNs(picks);
+	double asyncTotalNs = 0;
+	{
+		MessageLog log;
+		log.echo = false;
+		mismatches += log.spillTo(asyncPath.c_str()) ? 0 : 1;
+		log.startWriter(1);
+
+		start = Clock::now();
+		for (int i = 0; i < picks; ++i) {
+			Clock::time_point call = Clock::now();
+			log.printf(
+				"[ %f\t%f\t%f\t%f ]\n[ %f\t%f\t%f\t%f ]\n[ %f\t%f\t%f\t%f ]\n[ %f\t%f\t%f\t%f ]\n",
+				m.m[0][0], m.m[1][0], m.m[2][0], (float)i, m.m[0][1], m.m[1][1], m.m[2][1], (float)i,
+				m.m[0][2], m.m[1][2], m.m[2][2], (float)i, m.m[0][3], m.m[1][3], m.m[2][3], (float)i);
+			asyncNs[i] = nsSince(call, 1);
+		}
+		log.stopWriter();
+		asyncTotalNs = nsSince(start, picks);
+	}
+	lines = linesInLogFile(asyncPath, check, mismatches);
+	remove(asyncPath.c_str());
+	mismatches += lines == 4LL * picks ? 0 : 1;
+
+	start = Clock::now();
+	for (int i = 0; i < picks; ++i) {
+		m.Print();
+	}
+	double debugNs = nsSince(start, picks);
+
+	printf("log sink %i picks x 4 lines: written by caller p50 %6.0f ns p99 %7.0f ns, %.2f Mlines/s; ring + writer p50 %6.0f ns p99 %7.0f ns, %.2f Mlines/s; LOG_DEBUG %.1f ns; mismatches %i\n",
+		picks, latency(syncNs, 0.5), latency(syncNs, 0.99), 4e3 / syncTotalNs, latency(asyncNs, 0.5), latency(asyncNs, 0.99), 4e3 / asyncTotalNs, debugNs, mismatches);
+
+	return mismatches == 0;
+}
+
+static void benchMicro() {
+	printf("micro:\n");
+
+	mt19937 rng(9);
+	uniform_real_distribution<float> any(-10, 10);
+
+	vector<Vec3F> points(1024);
+	for (Vec3F& p : points) {
+		p = { any(rng), any(rng), any(rng) };
+	}
+
+	M44F rotation;
+	rotation.asRotateY(0.1f).Mult(M44F().asRotateX(0.2f));
+	M44F acc;
+	measure("M44::Mult", 1000000, [&](int) {
+		acc.Mult(rotation);
+		sink = acc.m[0][0];
+	});
+
+	acc = M44F();
+	measure("M44::MultScalar", 1000000, [&](int) {
+		acc.MultScalar(rotation);
+		sink = acc.m[0][0];
+	});
+
+	CubeShape shape;
+	shape.pos = { 1,2,3 };
+	shape.angle = { 10,20,30 };
+	shape.scale = { 1,2,1 };
+	M44F placed = shape.modelMatrix();
+	measure("M44::ApplyOnPoint", 1000000, [&](int i) {
+		sink = placed.ApplyOnPoint(points[i & 1023]).x;
+	});
+
+	vector<Vec3F> transformed(points.size());
+	measure("M44::ApplyOnPoints x1024", 2000, [&](int i) {
+		placed.ApplyOnPoints(points.data(), transformed.data(), (int)points.size());
+		sink = transformed[i & 1023].x;
+	});
+
+	measure("M44::ApplyOnPointsScalar x1024", 2000, [&](int i) {
+		placed.ApplyOnPointsScalar(points.data(), transformed.data(), (int)points.size());
+		sink = transformed[i & 1023].x;
+	});
+
+	measure("Vec3F::rotationYXZ", 1000000, [&](int i) {
+		sink = points[i & 1023].rotationYXZ(Vec3F::UP).x;
+	});
+
+	Camera turning;
+	measure("freespace turn, matrices + angles", 1000000, [&](int i) {
+		freespaceTurnEuler(turning, points[i & 1023].x * 0.1f, points[i & 1023].y * 0.1f);
+		sink = turning.angle.y;
+	});
+
+	turning = Camera();
+	measure("freespace turn, quaternion", 1000000, [&](int i) {
+		freespaceTurnQuat(turning, points[i & 1023].x * 0.1f, points[i & 1023].y * 0.1f);
+		sink = turning.orientation.w;
+	});
+
+	vector<CubeShape> cubes(1024);
+	for (CubeShape& c : cubes) {
+		c.pos = { any(rng), any(rng), any(rng) };
+		c.angle = { any(rng) * 18, any(rng) * 18, any(rng) * 18 };
+	}
+
+	// what modelMatrix() did before asTRS
+	measure("M44 TRS as Mult chain", 100000, [&](int i) {
+		const CubeShape& c = cubes[i & 1023];
+		M44F m;
+		m.asTranslate(c.pos.x, c.pos.y, c.pos.z)
+			.Mult(M44F().asRotateZ(rad(c.angle.z)))
+			.Mult(M44F().asRotateX(rad(c.angle.x)))
+			.Mult(M44F().asRotateY(rad(c.angle.y)))
+			.Mult(M44F().asScale(c.scale.x, c.scale.y, c.scale.z));
+		sink = m.m[3][0] + m.m[0][0];
+	});
+
+	measure("M44::asTRS", 100000, [&](int i) {
+		M44F m = cubes[i & 1023].modelMatrix();
+		sink = m.m[3][0] + m.m[0][0];
+	});
+
+	vector<M44F> models(cubes.size());
+	for (size_t i = 0; i < cubes.size(); ++i) {
+		models[i] = cubes[i].modelMatrix();
+	}
+
+	vector<Triangle> fill;
+	measure("ModelCube::mesh, per quad (36 transforms)", 100000, [&](int i) {
+		fill.clear();
+		meshShapeQuads(cubes[i & 1023], models[i & 1023], fill);
+		sink = fill[0].vertices[0].x;
+	});
+
+	measure("ModelCube::mesh, cached matrix (8 transforms)", 100000, [&](int i) {
+		fill.clear();
+		cubes[i & 1023].meshShape(models[i & 1023], fill);
+		sink = fill[0].vertices[0].x;
+	});
+
+	measure("ModelCube::mesh", 100000, [&](int i) {
+		fill.clear();
+		cubes[i & 1023].meshShape(fill);
+		sink = fill[0].vertices[0].x;
+	});
+
+	measure("ModelCube::mesh, fresh vector", 100000, [&](int i) {
+		vector<Triangle> fresh;
+		cubes[i & 1023].meshShape(fresh);
+		sink = fresh[0].vertices[0].x;
+	});
+
+	// what DrawPlane::buildFrameLines does each frame, with batch kept between frames
+	VertexBatch frameLines;
+	measure("VertexBatch, 100 lines + 1000 markers", 10000, [&](int i) {
+		frameLines.clear();
+		for (int l = 0; l < 100; ++l) {
+			frameLines.addLine(points[l], { 0,1,1 }, points[l + 100], { 1,1,0 });
+		}
+		for (int m = 0; m < 1000; ++m) {
+			frameLines.addCross(points[m], 0.1f, { 1,1,1 }, { 1,1,1 });
+		}
+		sink = frameLines.vertices[i & 1023].x;
+	});
+
+	for (int triangles : { 1000, 10000, 100000 }) {
+		vector<Triangle> scene = randomScene(triangles, rng);
+		vector<Line> rays = randomRays(64, rng);
+		char name[64];
+
+		HitTest linear;
+		linear.tris = scene;
+		snprintf(name, sizeof(name), "HitTest::check %i", triangles);
+		measure(name, 1000000 / triangles, [&](int i) {
+			linear.line = rays[i & 63];
+			sink = (float)linear.check();
+		});
+
+		BVH bvh;
+		bvh.build(scene);
+		TriangleSoA soa;
+		soa.assign(scene, bvh.order);
+
+		HitTest closest;
+		closest.query = HitClosest;
+		snprintf(name, sizeof(name), "HitTest::check %i bvh closest", triangles);
+		measure(name, 10000, [&](int i) {
+			closest.line = rays[i & 63];
+			sink = (float)closest.check(soa, bvh);
+		});
+	}
+
+	TextLayout layout;
+	string text = "The quick brown fox jumps over the lazy dog; 0123456789 {};':\",.<>|/\\? ~";
+	measure("TextPainter::charCoord", 1000000, [&](int i) {
+		int x, y;
+		layout.charCoord(text[i % text.size()], x, y);
+		sink = (float)(x + y);
+	});
+}
+
+int main() {
+	bool ok = true;
+
+	benchMicro();
+
+	ok &= verifyM44Simd(100000);
+	ok &= verifyTRS(100000);
+	ok &= verifyMeshPipeline(100000);
+	ok &= verifyQuat(100000);
+
+	ok &= verifyHitMethods(10000);
+	ok &= benchSimdKernels(100000);
+
+	ok &= benchPicking(1000);
+	ok &= benchPicking(10000);
+	ok &= benchPicking(100000);
+
+	ok &= benchPacket(10000, 32);
+	ok &= benchPacket(100000, 64);
+
+	ok &= benchFrustum(10000);
+	ok &= benchFrustum(100000);
+
+	ok &= benchThreads(1000000);
+
+	benchSceneMesh(1000);
+	benchSceneMesh(10000);
+
+	benchCubeBatch(10000);
+	benchCubeBatch(100000);
+
+	ok &= benchSceneStore(10000);
+	ok &= benchSceneStore(100000);
+
+	ok &= benchIdLookup(10000);
+	ok &= benchIdLookup(100000);
+
+	ok &= benchSpatialGrid(10000);
+	ok &= benchSpatialGrid(100000);
+
+	ok &= benchViewCulling(100000);
+	ok &= benchPixelMapping();
+
+	ok &= benchTextLayout(1000);
+	ok &= benchTextMesh(30);
+	ok &= benchOverlay(30);
+
+	ok &= benchLog(4, 100000);
+#ifdef EXPLORER3D_TEST_HOOKS
+	ok &= benchLogStalled(3);
+#else
+	printf("log stalled writer: needs EXPLORER3D_TEST_HOOKS, skipped\n");
+#endif
+	ok &= benchLogSink(20000);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#include <bvh.h>
+#include <cmath>
+#include <algorithm>
+
+static const int MAX_DEPTH = 48;
+
+static float axisOf(const Vec3F& v, int axis) {
+	return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+void AABB::grow(const Vec3F& p) {
+	if (p.x < lo.x) lo.x = p.x;
+	if (p.y < lo.y) lo.y = p.y;
+	if (p.z < lo.z) lo.z = p.z;
+
+	if (p.x > hi.x) hi.x = p.x;
+	if (p.y > hi.y) hi.y = p.y;
+	if (p.z > hi.z) hi.z = p.z;
+}
+
+void AABB::grow(const AABB& o) {
+	if (o.lo.x > o.hi.x) {
+		// empty box
+		return;
+	}
+
+	grow(o.lo);
+	grow(o.hi);
+}
+
+float AABB::area() const {
+	if (lo.x > hi.x) {
+		return 0;
+	}
+
+	Vec3F e = hi;
+	e.sub(lo);
+	return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+Vec3F AABB::center() const {
+	Vec3F c = lo;
+	c.add(hi);
+	return c.mult(0.5f);
+}
+
+bool AABB::empty() const {
+	return !(lo.x <= hi.x && lo.y <= hi.y && lo.z <= hi.z);
+}
+
+bool AABB::hitRay(const Vec3F& origin, const Vec3F& invDir, float tMax) const {
+	float tEnter;
+	return hitRay(origin, invDir, tMax, tEnter);
+}
+
+bool AABB::hitRay(const Vec3F& origin, const Vec3F& invDir, float tMax, float& tEnter) const {
+	float t1 = (lo.x - origin.x) * invDir.x;
+	float t2 = (hi.x - origin.x) * invDir.x;
+	tEnter = fminf(t1, t2);
+	float tExit = fmaxf(t1, t2);
+
+	t1 = (lo.y - origin.y) * invDir.y;
+	t2 = (hi.y - origin.y) * invDir.y;
+	tEnter = fmaxf(tEnter, fminf(t1, t2));
+	tExit = fminf(tExit, fmaxf(t1, t2));
+
+	t1 = (lo.z - origin.z) * invDir.z;
+	t2 = (hi.z - origin.z) * invDir.z;
+	tEnter = fmaxf(tEnter, fminf(t1, t2));
+	tExit = fminf(tExit, fmaxf(t1, t2));
+
+	// a bit of slack on exit, so rays grazing a flat box (all triangles on one plane) are not lost to rounding
+	tExit *= 1.0000004f;
+	tEnter = fmaxf(tEnter, 0);
+
+	return tExit >= tEnter && tEnter <= tMax;
+}
+
+void BVH::build(const vector<Triangle>& tris) {
+	nodes.clear();
+	parents.clear();
+	leafOf.clear();
+	slotOf.clear();
+	order.resize(tris.size());
+
+	if (tris.empty()) {
+		return;
+	}
+
+	vector<Vec3F> centers(tris.size());
+	for (size_t i = 0; i < tris.size(); ++i) {
+		order[i] = (int)i;
+
+		Vec3F c = tris[i].vertices[0];
+		c.add(tris[i].vertices[1]);
+		c.add(tris[i].vertices[2]);
+		centers[i] = c.mult(1.0f / 3);
+	}
+
+	// binary tree has at most 2n-1 nodes; reserving upfront keeps references stable during subdivide
+	nodes.reserve(tris.size() * 2);
+
+	BVHNode root;
+	root.first = 0;
+	root.count = (int)tris.size();
+	updateBounds(root, tris);
+	nodes.push_back(root);
+
+	subdivide(0, tris, centers, 0);
+	linkNodes();
+}
+
+void BVH::linkNodes() {
+	parents.assign(nodes.size(), -1);
+	leafOf.resize(order.size());
+	slotOf.resize(order.size());
+
+	for (int i = 0; i < (int)nodes.size(); ++i) {
+		const BVHNode& n = nodes[i];
+		if (n.count) {
+			for (int t = n.first; t < n.first + n.count; ++t) {
+				leafOf[order[t]] = i;
+				slotOf[order[t]] = t;
+			}
+		}
+		else {
+			parents[n.first] = i;
+			parents[n.first + 1] = i;
+		}
+	}
+}
+
+void BVH::refit(const vector<Triangle>& tris) {
+	// children are always allocated after parent, so walking backwards visits them first
+	for (int i = (int)nodes.size() - 1; i >= 0; --i) {
+		BVHNode& n = nodes[i];
+		if (n.count) {
+			updateBounds(n, tris);
+		}
+		else {
+			n.bounds = nodes[n.first].bounds;
+			n.bounds.grow(nodes[n.first + 1].bounds);
+		}
+	}
+}
+
+void BVH::refit(const vector<Triangle>& tris, int first, int count) {
+	int lastLeaf = -1;
+	for (int t = first; t < first + count; ++t) {
+		int leaf = leafOf[t];
+		if (leaf == lastLeaf) {
+			continue;
+		}
+		lastLeaf = leaf;
+
+		updateBounds(nodes[leaf], tris);
+
+		for (int p = parents[leaf]; p != -1; p = parents[p]) {
+			BVHNode& n = nodes[p];
+			n.bounds = nodes[n.first].bounds;
+			n.bounds.grow(nodes[n.first + 1].bounds);
+		}
+	}
+}
+
+void BVH::updateBounds(BVHNode& n, const vector<Triangle>& tris) const {
+	n.bounds = AABB();
+	for (int i = n.first; i < n.first + n.count; ++i) {
+		const Triangle& t = tris[order[i]];
+		n.bounds.grow(t.vertices[0]);
+		n.bounds.grow(t.vertices[1]);
+		n.bounds.grow(t.vertices[2]);
+	}
+}
+
+void BVH::subdivide(int nodeIdx, const vector<Triangle>& tris, const vector<Vec3F>& centers, int depth) {
+	BVHNode& n = nodes[nodeIdx];
+	if (n.count <= LEAF_SIZE || depth >= MAX_DEPTH) {
+		return;
+	}
+
+	AABB centroidBounds;
+	for (int i = n.first; i < n.first + n.count; ++i) {
+		centroidBounds.grow(centers[order[i]]);
+	}
+
+	Vec3F extent = centroidBounds.hi;
+	extent.sub(centroidBounds.lo);
+
+	int axis = 0;
+	if (extent.y > axisOf(extent, axis)) axis = 1;
+	if (extent.z > axisOf(extent, axis)) axis = 2;
+
+	float axisMin = axisOf(centroidBounds.lo, axis);
+	float axisExtent = axisOf(extent, axis);
+	if (axisExtent <= 0) {
+		// all centers in one point, nothing to split
+		return;
+	}
+
+	struct Bin {
+		AABB bounds;
+		int count = 0;
+	} bins[BINS];
+
+	float binScale = BINS / axisExtent;
+	auto binOf = [&](int triIdx) {
+		int b = (int)((axisOf(centers[triIdx], axis) - axisMin) * binScale);
+		return b < BINS - 1 ? b : BINS - 1;
+	};
+
+	for (int i = n.first; i < n.first + n.count; ++i) {
+		const Triangle& t = tris[order[i]];
+		Bin& b = bins[binOf(order[i])];
+		b.count += 1;
+		b.bounds.grow(t.vertices[0]);
+		b.bounds.grow(t.vertices[1]);
+		b.bounds.grow(t.vertices[2]);
+	}
+
+	// sweep from the right to get area * count of every right side, then from the left to evaluate each split
+	float rightCost[BINS];
+	AABB acc;
+	int accCount = 0;
+	for (int i = BINS - 1; i > 0; --i) {
+		acc.grow(bins[i].bounds);
+		accCount += bins[i].count;
+		rightCost[i] = acc.area() * accCount;
+	}
+
+	int bestSplit = -1;
+	float bestCost = FLT_MAX;
+	acc = AABB();
+	accCount = 0;
+	for (int i = 1; i < BINS; ++i) {
+		acc.grow(bins[i - 1].bounds);
+		accCount += bins[i - 1].count;
+
+		float cost = acc.area() * accCount + rightCost[i];
+		if (cost < bestCost) {
+			bestCost = cost;
+			bestSplit = i;
+		}
+	}
+
+	// SAH: traversal step costs about as much as one triangle test
+	float parentArea = n.bounds.area();
+	float splitCost = 1 + (parentArea > 0 ? bestCost / parentArea : 0);
+	if (splitCost >= n.count && n.count <= 4 * LEAF_SIZE) {
+		return;
+	}
+
+	int* begin = order.data() + n.first;
+	int* end = begin + n.count;
+	int* mid = partition(begin, end, [&](int triIdx) { return binOf(triIdx) < bestSplit; });
+
+	int leftCount = (int)(mid - begin);
+	if (leftCount == 0 || leftCount == n.count) {
+		return;
+	}
+
+	BVHNode left;
+	left.first = n.first;
+	left.count = leftCount;
+	updateBounds(left, tris);
+
+	BVHNode right;
+	right.first = n.first + leftCount;
+	right.count = n.count - leftCount;
+	updateBounds(right, tris);
+
+	n.first = (int)nodes.size();
+	n.count = 0;
+
+	nodes.push_back(left);
+	nodes.push_back(right);
+
+	int leftIdx = n.first;
+	subdivide(leftIdx, tris, centers, depth + 1);
+	subdivide(leftIdx + 1, tris, centers, depth + 1);
+}
@@ -0,0 +1,76 @@
+#include <camera.h>
+
+const float Camera::fovMax = 175;
+const float Camera::fovMin = 5;
+
+Line Camera::lineAt(const XYFloat& xy, float windowHeight, float range) const {
+	M44F m = eyeMatrix();
+
+	// align xy to view top left corner
+	float x = xy.x - viewPos.x;
+	float y = xy.y - (windowHeight - viewPos.y - viewSize.y);
+
+	// extents as applyProjection sets them, so this works before the view was drawn
+	ClippingRange r = calculateClippingRange();
+
+	Vec3F lineStart = { 0,0,0 };
+	Vec3F lineEnd = { 0,0,0 };
+	if (perspective) {
+		float xRatio = x / viewSize.x * 2 - 1;
+		float yRatio = y / viewSize.y * 2 - 1;
+
+		lineEnd = { xRatio * r.right, -yRatio * r.top, -nearPlane };
+		lineEnd.normalize().mult(range);
+	}
+	else {
+		float pRight = r.left + (r.right - r.left) * x / viewSize.x;
+		float pTop = r.top - (r.top - r.bottom) * y / viewSize.y;
+
+		lineStart = { pRight, pTop, 100 };
+		lineEnd = { pRight, pTop, -range };
+	}
+
+	return { m.ApplyOnPoint(lineStart), m.ApplyOnPoint(lineEnd) };
+}
+
+void Camera::linesInRect(XYFloat a, XYFloat b, float step, float windowHeight, vector<Line>& lines) const {
+	lines.clear();
+
+	// no step, or NaN, would never get across; less than a pixel gives nothing new
+	if (!(step > 0)) {
+		return;
+	}
+	step = fmaxf(step, 1);
+
+	float viewTop = windowHeight - viewPos.y - viewSize.y;
+	float left = fmaxf(fminf(a.x, b.x), viewPos.x), right = fminf(fmaxf(a.x, b.x), viewPos.x + viewSize.x);
+	float top = fmaxf(fminf(a.y, b.y), viewTop), bottom = fminf(fmaxf(a.y, b.y), viewTop + viewSize.y);
+	if (!(left <= right && top <= bottom)) {
+		return;
+	}
+
+	// counted, not stepped by adding floats, which stalls once step is below what the coordinate can still tell
+	int columns = (int)((right - left) / step) + 1;
+	int rows = (int)((bottom - top) / step) + 1;
+
+	// row by row, so neighbouring lines stay next to each other in a packet
+	for (int row = 0; row < rows; ++row) {
+		for (int column = 0; column < columns; ++column) {
+			lines.push_back(lineAt({ left + column * step, top + row * step }, windowHeight, farPlane));
+		}
+	}
+}
+
+Frustum Camera::frustumInRect(XYFloat a, XYFloat b, float windowHeight) const {
+	ClippingRange r = calculateClippingRange();
+
+	// same pixel to view mapping as lineAt
+	float viewTop = windowHeight - viewPos.y - viewSize.y;
+	auto viewX = [&](float x) { return r.left + (r.right - r.left) * (x - viewPos.x) / viewSize.x; };
+	auto viewY = [&](float y) { return r.top - (r.top - r.bottom) * (y - viewTop) / viewSize.y; };
+
+	float left = fminf(a.x, b.x), right = fmaxf(fmaxf(a.x, b.x), left + 1);
+	float top = fminf(a.y, b.y), bottom = fmaxf(fmaxf(a.y, b.y), top + 1);
+
+	return Frustum::fromView(eyeMatrix(), perspective, viewX(left), viewX(right), viewY(bottom), viewY(top), nearPlane, farPlane);
+}
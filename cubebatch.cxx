@@ -0,0 +1,33 @@
+#include <cubebatch.h>
+
+static const int CUBE_FLOATS = CubeShape::VERTICES * 3;
+
+void CubeBatch::add(const M44F& model, bool wireframe) {
+	if ((size_t)(cubes + 1) * CUBE_FLOATS > positions.size()) {
+		grow();
+	}
+
+	TransformedVertices<CubeShape::VERTICES> world;
+	world.transform(model, CubeShape::vertices.data());
+	world.interleave(positions.data() + cubes * CUBE_FLOATS);
+
+	if (wireframe) {
+		unsigned int base = cubes * CubeShape::VERTICES;
+		for (unsigned int e : CubeShape::edgeIndices) {
+			edges.push_back(base + e);
+		}
+	}
+
+	++cubes;
+}
+
+// one more cube slot
+void CubeBatch::grow() {
+	unsigned int base = (unsigned int)(positions.size() / 3);
+
+	positions.resize(positions.size() + CUBE_FLOATS);
+	colors.insert(colors.end(), CubeShape::colors.begin(), CubeShape::colors.end());
+	for (unsigned int f : CubeShape::facesIndices) {
+		faces.push_back(base + f);
+	}
+}
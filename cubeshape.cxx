@@ -0,0 +1,53 @@
+#include <cubeshape.h>
+
+const array<unsigned int, 24> CubeShape::facesIndices = {
+		0,1,2,3, // -z
+		4,5,6,7, // +z
+
+		0,1,5,4, // -x
+		2,3,7,6, // +x
+
+		1,2,6,5, // -y
+		0,3,7,4, // +y
+};
+
+const array<unsigned int, 36> CubeShape::triangleIndices = {
+		0,1,2, 2,3,0, // -z
+		4,5,6, 6,7,4, // +z
+
+		0,1,5, 5,4,0, // -x
+		2,3,7, 7,6,2, // +x
+
+		1,2,6, 6,5,1, // -y
+		0,3,7, 7,4,0, // +y
+};
+
+const array<unsigned int, 24> CubeShape::edgeIndices = {
+		0,1, 1,2, 2,3, 3,0, // -z
+		4,5, 5,6, 6,7, 7,4, // +z
+		0,4, 1,5, 2,6, 3,7, // between
+};
+
+const array<float, 24> CubeShape::vertices = {
+		-1, 1,-1,
+		-1,-1,-1,
+		 1,-1,-1,
+		 1, 1,-1,
+
+		-1, 1, 1,
+		-1,-1, 1,
+		 1,-1, 1,
+		 1, 1, 1,
+};
+
+const array<float, 24> CubeShape::colors = {
+		1.0, 0.0, 0.0,
+		0.0, 0.1, 0.0,
+		0.0, 0.0, 1.0,
+		1.0, 1.0, 0.0,
+
+		0.0, 1.0, 1.0,
+		1.0, 0.0, 1.0,
+		1.0, 1.0, 1.0,
+		0.3, 0.3, 0.3,
+};
@@ -0,0 +1,182 @@
+#include <frustum.h>
+#include <algorithm>
+
+static float dot(const Vec3F& a, const Vec3F& b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// plane through a, b, c, turned so that inner point is on positive side
+static Plane planeOf(const Vec3F& a, const Vec3F& b, const Vec3F& c, const Vec3F& inner) {
+	Vec3F ab = b;
+	ab.sub(a);
+	Vec3F ac = c;
+	ac.sub(a);
+
+	Plane p;
+	p.n = ab.crossProduct(ac);
+	p.d = -dot(p.n, a);
+
+	if (p.distance(inner) < 0) {
+		p.n.mult(-1);
+		p.d = -p.d;
+	}
+
+	return p;
+}
+
+Frustum Frustum::fromView(const M44F& eyeToWorld, bool perspective, float left, float right, float bottom, float top, float nearPlane, float farPlane) {
+	// camera looks along -z in eye space; perspective far face is near face scaled up
+	float farScale = perspective ? farPlane / nearPlane : 1;
+
+	Vec3F eye[8] = {
+		{ left, bottom, -nearPlane },
+		{ right, bottom, -nearPlane },
+		{ right, top, -nearPlane },
+		{ left, top, -nearPlane },
+		{ left * farScale, bottom * farScale, -farPlane },
+		{ right * farScale, bottom * farScale, -farPlane },
+		{ right * farScale, top * farScale, -farPlane },
+		{ left * farScale, top * farScale, -farPlane },
+	};
+
+	Frustum f;
+	Vec3F inner = { 0,0,0 };
+	for (int i = 0; i < 8; ++i) {
+		f.corners[i] = eyeToWorld.ApplyOnPoint(eye[i]);
+		inner.add(f.corners[i]);
+	}
+	inner.mult(1.0f / 8);
+
+	const Vec3F* c = f.corners;
+	f.planes[0] = planeOf(c[0], c[3], c[7], inner);
+	f.planes[1] = planeOf(c[1], c[5], c[6], inner);
+	f.planes[2] = planeOf(c[0], c[4], c[5], inner);
+	f.planes[3] = planeOf(c[3], c[2], c[6], inner);
+	f.planes[4] = planeOf(c[0], c[1], c[2], inner);
+	f.planes[5] = planeOf(c[4], c[7], c[6], inner);
+
+	return f;
+}
+
+FrustumSide Frustum::classify(const AABB& box) const {
+	FrustumSide side = FrustumInside;
+
+	for (const Plane& p : planes) {
+		// corner farthest along the normal, and the opposite one
+		Vec3F farthest = {
+			p.n.x >= 0 ? box.hi.x : box.lo.x,
+			p.n.y >= 0 ? box.hi.y : box.lo.y,
+			p.n.z >= 0 ? box.hi.z : box.lo.z,
+		};
+		Vec3F nearest = {
+			p.n.x >= 0 ? box.lo.x : box.hi.x,
+			p.n.y >= 0 ? box.lo.y : box.hi.y,
+			p.n.z >= 0 ? box.lo.z : box.hi.z,
+		};
+
+		if (p.distance(farthest) < 0) {
+			return FrustumOutside;
+		}
+
+		if (p.distance(nearest) < 0) {
+			side = FrustumIntersects;
+		}
+	}
+
+	return side;
+}
+
+bool Frustum::overlaps(const Triangle& t) const {
+	// triangle clipped by 6 planes gets at most 3 + 6 vertices
+	Vec3F polygon[9];
+	Vec3F clipped[9];
+	int count = 3;
+	for (int i = 0; i < 3; ++i) {
+		polygon[i] = t.vertices[i];
+	}
+
+	for (const Plane& p : planes) {
+		int out = 0;
+		for (int i = 0; i < count; ++i) {
+			const Vec3F& a = polygon[i];
+			const Vec3F& b = polygon[(i + 1) % count];
+			float da = p.distance(a);
+			float db = p.distance(b);
+
+			if (da >= 0) {
+				clipped[out++] = a;
+			}
+
+			if ((da >= 0) != (db >= 0)) {
+				Vec3F ab = b;
+				ab.sub(a).mult(da / (da - db));
+				clipped[out++] = ab.add(a);
+			}
+		}
+
+		if (out == 0) {
+			return false;
+		}
+
+		count = out;
+		copy(clipped, clipped + count, polygon);
+	}
+
+	return true;
+}
+
+int Frustum::collectIds(const BVH& bvh, const vector<Triangle>& tris, vector<int>& ids) const {
+	ids.clear();
+	if (bvh.empty()) {
+		return 0;
+	}
+
+	// second member tells that node is already known to be inside, so nothing below needs a test
+	struct Pending {
+		int node;
+		bool inside;
+	} stack[64];
+
+	int top = 0;
+	int visited = 0;
+	stack[top++] = { 0, false };
+
+	while (top > 0) {
+		Pending p = stack[--top];
+		const BVHNode& n = bvh.nodes[p.node];
+		++visited;
+
+		bool inside = p.inside;
+		if (!inside) {
+			FrustumSide side = classify(n.bounds);
+			if (side == FrustumOutside) {
+				continue;
+			}
+			inside = side == FrustumInside;
+		}
+
+		if (n.count) {
+			for (int i = n.first; i < n.first + n.count; ++i) {
+				const Triangle& t = tris[bvh.order[i]];
+
+				// triangles of one renderable mostly sit in the same leaves; one hit is enough
+				if (!ids.empty() && ids.back() == t.id) {
+					continue;
+				}
+
+				if (inside || overlaps(t)) {
+					ids.push_back(t.id);
+				}
+			}
+		}
+		else {
+			stack[top++] = { n.first, inside };
+			stack[top++] = { n.first + 1, inside };
+		}
+	}
+
+	sort(ids.begin(), ids.end());
+	ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+	return visited;
+}
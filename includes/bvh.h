@@ -0,0 +1,170 @@
+#pragma once
+#include <vector>
+#include <cfloat>
+#include <geometry.h>
+
+using namespace std;
+
+struct AABB {
+	Vec3F lo = { FLT_MAX, FLT_MAX, FLT_MAX };
+	Vec3F hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	void grow(const Vec3F& p);
+	void grow(const AABB& o);
+	float area() const;
+	Vec3F center() const;
+	// nothing grown into it yet, or NaN in it
+	bool empty() const;
+
+	// slab test against ray origin + t * dir, t in [0, tMax]; invDir is 1/dir per axis
+	bool hitRay(const Vec3F& origin, const Vec3F& invDir, float tMax) const;
+	bool hitRay(const Vec3F& origin, const Vec3F& invDir, float tMax, float& tEnter) const;
+};
+
+struct BVHNode {
+	AABB bounds;
+	int first = 0;	// leaf: first index into BVH::order, inner: index of left child (right is first + 1)
+	int count = 0;	// number of triangles in leaf, 0 for inner node
+};
+
+// Bounding volume hierarchy over world space triangles, built with binned SAH.
+// Triangles are not copied - tree keeps indices into the vector it was built from,
+// so refit() after vertices moved must get the same vector (same size and order).
+struct BVH {
+	static const int BINS = 12;
+	static const int LEAF_SIZE = 4;
+
+	vector<BVHNode> nodes;
+	vector<int> order;
+	vector<int> parents;	// per node, -1 for root
+	vector<int> leafOf;		// per triangle, node holding it
+	vector<int> slotOf;		// per triangle, its position in order
+
+	void build(const vector<Triangle>& tris);
+	void refit(const vector<Triangle>& tris);
+
+	// refits only leaves holding triangles [first, first + count) and their ancestors
+	void refit(const vector<Triangle>& tris, int first, int count);
+
+	bool empty() const {
+		return nodes.empty();
+	}
+
+	// calls visitLeaf(first, count) for every leaf crossed by the ray starting at line.first towards line.second,
+	// where [first, first + count) is a range in order; ray is infinite same as in HitTest::check
+	template <typename F> int traverseLeaves(const Line& line, F visitLeaf) const {
+		if (nodes.empty()) {
+			return 0;
+		}
+
+		Vec3F dir = line.second;
+		dir.sub(line.first);
+		Vec3F invDir = inverseDir(dir);
+
+		int stack[64];
+		int top = 0;
+		int visited = 0;
+		stack[top++] = 0;
+
+		while (top > 0) {
+			const BVHNode& n = nodes[stack[--top]];
+			++visited;
+			if (!n.bounds.hitRay(line.first, invDir, FLT_MAX)) {
+				continue;
+			}
+
+			if (n.count) {
+				visitLeaf(n.first, n.count);
+			}
+			else {
+				stack[top++] = n.first;
+				stack[top++] = n.first + 1;
+			}
+		}
+
+		return visited;
+	}
+
+	// closest hit traversal: nearer child is visited first, and nodes entered beyond tMax are skipped;
+	// visitLeaf(first, count) returns distance of the best hit so far (FLT_MAX if none), which becomes new tMax
+	template <typename F> int traverseLeavesNearest(const Line& line, F visitLeaf) const {
+		if (nodes.empty()) {
+			return 0;
+		}
+
+		Vec3F dir = line.second;
+		dir.sub(line.first);
+		Vec3F invDir = inverseDir(dir);
+
+		struct Pending {
+			int node;
+			float tEnter;
+		} stack[64];
+
+		int top = 0;
+		int visited = 0;
+		float tMax = FLT_MAX;
+
+		float tEnter;
+		if (!nodes[0].bounds.hitRay(line.first, invDir, tMax, tEnter)) {
+			return 1;
+		}
+		stack[top++] = { 0, tEnter };
+
+		while (top > 0) {
+			Pending p = stack[--top];
+			if (p.tEnter > tMax) {
+				continue;
+			}
+
+			const BVHNode& n = nodes[p.node];
+			++visited;
+
+			if (n.count) {
+				tMax = visitLeaf(n.first, n.count);
+				continue;
+			}
+
+			float tLeft, tRight;
+			bool left = nodes[n.first].bounds.hitRay(line.first, invDir, tMax, tLeft);
+			bool right = nodes[n.first + 1].bounds.hitRay(line.first, invDir, tMax, tRight);
+
+			// push farther one first, so nearer is popped first
+			if (left && right) {
+				bool leftFirst = tLeft <= tRight;
+				stack[top++] = leftFirst ? Pending{ n.first + 1, tRight } : Pending{ n.first, tLeft };
+				stack[top++] = leftFirst ? Pending{ n.first, tLeft } : Pending{ n.first + 1, tRight };
+			}
+			else if (left) {
+				stack[top++] = { n.first, tLeft };
+			}
+			else if (right) {
+				stack[top++] = { n.first + 1, tRight };
+			}
+		}
+
+		return visited;
+	}
+
+	// calls visit(triangleIndex) for every triangle in leaves crossed by the ray
+	template <typename F> int traverse(const Line& line, F visit) const {
+		return traverseLeaves(line, [&](int first, int count) {
+			for (int i = first; i < first + count; ++i) {
+				visit(order[i]);
+			}
+		});
+	}
+
+	static Vec3F inverseDir(const Vec3F& dir) {
+		return {
+			dir.x != 0 ? 1 / dir.x : FLT_MAX,
+			dir.y != 0 ? 1 / dir.y : FLT_MAX,
+			dir.z != 0 ? 1 / dir.z : FLT_MAX,
+		};
+	}
+
+private:
+	void subdivide(int nodeIdx, const vector<Triangle>& tris, const vector<Vec3F>& centers, int depth);
+	void updateBounds(BVHNode& n, const vector<Triangle>& tris) const;
+	void linkNodes();
+};
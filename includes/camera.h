@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <trig.h>
+#include <m44.h>
+#include <quat.h>
+#include <frustum.h>
+#include <log.h>
+#include <ui.h>
+
+using namespace std;
+
+struct ClippingRange {
+	float left;
+	float right;
+	float bottom;
+	float top;
+};
+
+// objects at last render of a view; culled ones had boxes outside of its frustum and were not drawn
+struct ViewStats {
+	int visible = 0;
+	int culled = 0;
+};
+
+struct Camera {
+	static const float fovMax;
+	static const float fovMin;
+
+	float nearPlane = 0.1;
+	float farPlane = 100;
+	
+	bool perspective = true;
+	bool adjustOrtho = false;
+	float frustumRight = 0;
+	float frustumTop = 0;
+	double fov = 60;
+
+	Vec3F pos = { 0,0,0 };
+	Vec3F angle = { 0,0,0 };
+
+	// freespace movement keeps rotation as quaternion, so turns compose without going back to angles
+	OrientationMode orientationMode = OrientationEuler;
+	Quat orientation;
+
+	XYFloat viewPos = { 0,0 };
+	XYFloat viewSize = { 0,0 };
+
+	ClippingRange orthoRange = { -1, 1, -1,1 };
+	float zoomFactor = 1;
+
+	ViewStats stats;
+	
+	void applyCameraWheel(float dy) {
+		if (perspective) {
+			updateFov(fov -dy);
+		}
+		else if (adjustOrtho) {
+			zoomFactor -= 0.02 * dy;
+		}
+	}
+
+	void applyCameraDrag(float dx, float dy) {
+		if (perspective) {
+			return;
+		}
+
+		XYFloat unit = pixelRange();
+		Vec3F posDiff = { -dx * unit.x, -dy * unit.y, 0 };
+
+		if (orientationMode == OrientationQuat) {
+			posDiff = orientation.ApplyOnPoint(posDiff);
+		}
+		else {
+			posDiff = M44F().asRotateX(rad(angle.x)).ApplyOnPoint(posDiff);
+			posDiff = M44F().asRotateY(rad(angle.y)).ApplyOnPoint(posDiff);
+			posDiff = M44F().asRotateZ(rad(angle.z)).ApplyOnPoint(posDiff);
+		}
+
+		pos.add(posDiff);
+
+	}
+
+	void updateFov(float newFov) {
+		fov = max<float>(min<float>(newFov, fovMax), fovMin);
+	}
+
+	XYFloat pixelRange() const {
+		ClippingRange r = calculateClippingRange();
+		return {
+			(r.right - r.left) / viewSize.x,
+			(r.bottom - r.top) / viewSize.y,
+		};
+	}
+
+	// GL state for this view: viewport, projection, and eye transform on top of current modelview; defined next to the renderer
+	void applyViewport();
+	void applyProjection();
+	void eyeCoords() const;
+
+	ClippingRange calculateClippingRange() const {
+		if (!perspective && !adjustOrtho) {
+			return orthoRange;
+		}
+
+		ClippingRange c;
+		double aspectRatio;
+		aspectRatio = (1.0 * viewSize.x) / viewSize.y;
+
+		if (perspective) {
+			double tangent = tan(rad(fov / 2));
+
+			c.top = tangent * nearPlane;
+			c.right = c.top;
+			if (viewSize.x > viewSize.y) {
+				c.right *= aspectRatio;
+			}
+			else {
+				c.top /= aspectRatio;
+			}
+		}
+		else {
+			if (viewSize.x > viewSize.y) {
+				c.right = orthoRange.right;
+				c.top = orthoRange.top / aspectRatio;
+			}
+			else {
+				c.right = orthoRange.right * aspectRatio;
+				c.top = orthoRange.top;
+			}
+
+			c.right *= zoomFactor;
+			c.top *= zoomFactor;
+		}
+
+		c.left = -c.right;
+		c.bottom = -c.top;
+
+		return c;
+
+	}
+
+	// eye rotation in world, whichever way it is kept
+	Quat rotation() const {
+		if (orientationMode == OrientationQuat) {
+			return orientation;
+		}
+
+		return Quat::fromYXZ({ (float)rad(angle.x), (float)rad(angle.y), (float)rad(angle.z) });
+	}
+
+	// current rotation is carried over; angles are taken from quaternion only here, not on every turn
+	void setOrientationMode(OrientationMode mode) {
+		if (mode == orientationMode) {
+			return;
+		}
+
+		if (mode == OrientationQuat) {
+			orientation = rotation();
+		}
+		else {
+			angle = eulerAngles();
+		}
+
+		orientationMode = mode;
+	}
+
+	// degrees, Y X Z order
+	Vec3F eulerAngles() const {
+		if (orientationMode == OrientationEuler) {
+			return angle;
+		}
+
+		Vec3F r = orientation.anglesYXZ();
+		return { (float)deg(r.x), (float)deg(r.y), (float)deg(r.z) };
+	}
+
+	// eye space to world space; inverse of what eyeCoords() applies
+	M44F eyeMatrix() const {
+		if (orientationMode == OrientationQuat) {
+			return orientation.asTRS(pos, { 1,1,1 });
+		}
+
+		M44F m;
+		m
+			.Mult(M44F().asTranslate(pos.x, pos.y, pos.z))
+			.Mult(M44F().asRotateY(rad(angle.y)))
+			.Mult(M44F().asRotateX(rad(angle.x)))
+			.Mult(M44F().asRotateZ(rad(angle.z)));
+
+		return m;
+	}
+
+	// world volume applyProjection shows (glFrustum or glOrtho), from near to far plane
+	Frustum viewFrustum() const {
+		ClippingRange r = calculateClippingRange();
+		return Frustum::fromView(eyeMatrix(), perspective, r.left, r.right, r.bottom, r.top, nearPlane, farPlane);
+	}
+
+	// Window pixels to world, for views placed by viewPos counted from window bottom as glViewport does; window y grows
+	// downwards, so windowHeight is needed to find the view.
+
+	// line from the eye through pixel xy, range long (perspective); from behind the eye to range in front of it (ortho)
+	Line lineAt(const XYFloat& xy, float windowHeight, float range) const;
+
+	// lines through pixels of rectangle a-b clipped to the view, row by row, one every step pixels (at least one);
+	// none when step is not above 0. Lines are from the eye to far plane
+	void linesInRect(XYFloat a, XYFloat b, float step, float windowHeight, vector<Line>& lines) const;
+
+	// part of view under rectangle a-b, between near and far plane; at least one pixel across, flat one has no inside
+	Frustum frustumInRect(XYFloat a, XYFloat b, float windowHeight) const;
+
+	void reset() {
+		pos = { 0,0,0 };
+		angle = { 0,0,0 };
+		orientation = Quat();
+		fov = 0;
+	}
+
+	void displayCoords() const {
+		Vec3F a = eulerAngles();
+		Log.printf("[ %.3f %.3f %.3f ], [%.3f %.3f %.3f]\n", pos.x, pos.y, pos.z, a.x, a.y, a.z);
+	}
+};
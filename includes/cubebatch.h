@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <m44.h>
+#include <cubeshape.h>
+
+using namespace std;
+
+// cubes of one frame transformed on CPU into one vertex array, so all of them go in one draw call for faces and one for
+// wireframes; geometry is taken from CubeShape, an instance only brings its model matrix and wireframe flag
+struct CubeBatch {
+	vector<float> positions;	// xyz, 8 per cube
+	vector<float> colors;		// rgb, CubeShape::colors repeated; written once per cube slot
+	vector<unsigned int> faces;	// quads, CubeShape::facesIndices shifted to each cube; written once per cube slot
+	vector<unsigned int> edges;	// lines, only for cubes with wireframe
+
+	int cubes = 0;
+
+	// slots are kept, so next frame with as many cubes does not touch colors and faces
+	void clear() {
+		cubes = 0;
+		edges.clear();
+	}
+
+	void add(const M44F& model, bool wireframe);
+
+	int faceIndexCount() const {
+		return cubes * (int)CubeShape::facesIndices.size();
+	}
+
+private:
+	void grow();
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <geometry.h>
+#include <bvh.h>
+#include <meshpipeline.h>
+#include <quat.h>
+
+using namespace std;
+
+// Placement and geometry of a cube with corners at -1/1, without any GL; SceneStore keeps cubes of the scene, CubeBatch draws them.
+// Vertices, faces and colors are the same for every cube, so they are kept once.
+struct CubeShape {
+	static const array<unsigned int, 24> facesIndices;
+	static const array<float, 24> vertices;
+	static const array<float, 24> colors;
+	static const array<unsigned int, 36> triangleIndices;	// 2 per face, split the same way as Quad::asTris
+	static const array<unsigned int, 24> edgeIndices;	// 12 edges as line pairs, for wireframe
+
+	static const int VERTICES = 8;
+	static const int TRIANGLES = 12;
+
+	int id = 0;
+	Vec3F pos = { 0,0,0 };
+	Vec3F angle = { 0,0,0 };
+	Vec3F scale = { 1,1,1 };
+
+	OrientationMode orientationMode = OrientationEuler;
+	Quat orientation;	// used instead of angle in OrientationQuat mode
+
+	// translate * rotZ * rotX * rotY * scale, or translate * orientation * scale
+	M44F modelMatrix() const {
+		if (orientationMode == OrientationQuat) {
+			return orientation.asTRS(pos, scale);
+		}
+
+		Vec3F radians = { (float)rad(angle.x), (float)rad(angle.y), (float)rad(angle.z) };
+		return M44F().asTRS(pos, radians, scale);
+	}
+
+	// world box of cube placed by m: center is translation, half size along each axis is the sum of |column| there
+	static AABB boundsOf(const M44F& m) {
+		Vec3F half = {
+			fabsf(m.m[0][0]) + fabsf(m.m[1][0]) + fabsf(m.m[2][0]),
+			fabsf(m.m[0][1]) + fabsf(m.m[1][1]) + fabsf(m.m[2][1]),
+			fabsf(m.m[0][2]) + fabsf(m.m[1][2]) + fabsf(m.m[2][2])
+		};
+
+		AABB b;
+		b.lo = { m.m[3][0] - half.x, m.m[3][1] - half.y, m.m[3][2] - half.z };
+		b.hi = { m.m[3][0] + half.x, m.m[3][1] + half.y, m.m[3][2] + half.z };
+		return b;
+	}
+
+	// 12 world space triangles, 2 per face
+	void meshShape(vector<Triangle> &fill) const {
+		meshShape(modelMatrix(), fill);
+	}
+
+	// same, with model matrix already at hand; each of 8 vertices is transformed once, then triangles are expanded
+	void meshShape(const M44F& m, vector<Triangle> &fill) const {
+		TransformedVertices<VERTICES> world;
+		world.transform(m, vertices.data());
+		world.emitTriangles(id, triangleIndices.data(), TRIANGLES, fill);
+	}
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <geometry.h>
+#include <bvh.h>
+
+using namespace std;
+
+// n . p + d >= 0 on the inner side
+struct Plane {
+	Vec3F n;
+	float d;
+
+	float distance(const Vec3F& p) const {
+		return n.x * p.x + n.y * p.y + n.z * p.z + d;
+	}
+};
+
+enum FrustumSide {
+	FrustumOutside,
+	FrustumIntersects,
+	FrustumInside,
+};
+
+// Convex volume bounded by 6 planes, in world space; either a pyramid cut by near and far plane (perspective)
+// or a box (ortho). Used for region selection (a screen rectangle becomes a sub-frustum of the camera) and for culling whole views.
+struct Frustum {
+	Plane planes[6];	// left, right, bottom, top, near, far
+	Vec3F corners[8];	// near: bl, br, tr, tl; then far in the same order
+
+	// left/right/bottom/top are eye space extents as for glFrustum (at near plane) or glOrtho; eyeToWorld places the eye
+	static Frustum fromView(const M44F& eyeToWorld, bool perspective, float left, float right, float bottom, float top, float nearPlane, float farPlane);
+
+	// plane test only, so a box near an edge of the frustum may get FrustumIntersects while being outside
+	FrustumSide classify(const AABB& box) const;
+
+	// exact: triangle is clipped by all planes, and something has to remain
+	bool overlaps(const Triangle& t) const;
+
+	// ids of triangles overlapping the frustum, sorted and unique; whole subtrees inside are taken without testing triangles.
+	// tris is what bvh was built from. Returns number of visited nodes.
+	int collectIds(const BVH& bvh, const vector<Triangle>& tris, vector<int>& ids) const;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <trig.h>
+#include <m44.h>
+
+using namespace std;
+
+struct Line {
+	Vec3F first;
+	Vec3F second;
+};
+
+struct Triangle {
+	int id;
+	Vec3F vertices[3];
+
+	Vec3F normal() const {
+		Vec3F a = vertices[2];
+		Vec3F b = vertices[2];
+
+		a.sub(vertices[0]);
+		b.sub(vertices[1]);
+
+		return a.crossProduct(b);
+	}
+
+	void transform(const M44F& m) {
+		m.ApplyOnPoints(vertices, vertices, 3);
+	}
+};
+
+struct Quad {
+	int id;
+	array<Vec3F,4> vertices;
+
+	Quad(int aId, const float* aVertices, const unsigned int* faces) : id(aId), vertices({}) {
+		for (int i = 0; i < 4; ++i) {
+			int idx = faces[i]*3;
+			vertices[i] = {
+				aVertices[idx + 0],
+				aVertices[idx + 1],
+				aVertices[idx + 2]
+			};
+		}
+	}
+
+	pair<Triangle, Triangle> asTris() {
+		pair<Triangle, Triangle> p;
+		p.first = { id, {vertices[0], vertices[1], vertices[2]} };
+		p.second = { id, {vertices[2], vertices[3], vertices[0]} };
+		return p;
+	}
+};
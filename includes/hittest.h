@@ -0,0 +1,546 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <geometry.h>
+#include <bvh.h>
+#include <trisoa.h>
+#include <threadpool.h>
+#include <spatialgrid.h>
+
+using namespace std;
+
+template<typename T> int comp(const T& a, const T& b) {
+	return a < b;
+};
+
+enum HitMethod {
+	HitReference,		// aligns every triangle so line goes along Z axis, then tests it in 2d; kept to validate the other one
+	HitMollerTrumbore,	// ray/triangle test straight in world space, no matrix per triangle
+};
+
+enum HitQuery {
+	HitAll,		// every hit, ordered by distance
+	HitClosest,	// only the nearest hit; triangles and bvh nodes farther than the best so far are skipped
+};
+
+struct HitPosition {
+	int id;
+	Vec3F v;
+	float t;		// distance along line, in units of line.second - line.first
+	float baryU;	// barycentric weights of vertices[1] and vertices[2]; only HitMollerTrumbore fills them
+	float baryV;
+
+	static int Ordered(const HitPosition& a, const HitPosition& b) {
+		// ascending, as smaller t = closer
+		return comp(a.t, b.t);
+	}
+};
+
+struct HitTest {
+	vector<Triangle> tris;
+	vector<HitPosition> hits;
+	Line line;
+	HitMethod method = HitMollerTrumbore;
+	HitQuery query = HitAll;
+
+	// Moller-Trumbore; hit point is origin + t * dir = (1 - u - v) * vertices[0] + u * vertices[1] + v * vertices[2]
+	// written out per component, so it stays inline without calls into Vec3F
+	static bool intersect(const Vec3F& origin, const Vec3F& dir, const Triangle& tri, float& t, float& u, float& v) {
+		const Vec3F& v0 = tri.vertices[0];
+		const Vec3F& v1 = tri.vertices[1];
+		const Vec3F& v2 = tri.vertices[2];
+
+		float e1x = v1.x - v0.x, e1y = v1.y - v0.y, e1z = v1.z - v0.z;
+		float e2x = v2.x - v0.x, e2y = v2.y - v0.y, e2z = v2.z - v0.z;
+
+		// p = dir x e2
+		float px = dir.y * e2z - dir.z * e2y;
+		float py = dir.z * e2x - dir.x * e2z;
+		float pz = dir.x * e2y - dir.y * e2x;
+
+		float det = e1x * px + e1y * py + e1z * pz;
+
+		// line is parallel to triangle plane; triangle is seen edge on, so reference test would not hit it either
+		if (det == 0) {
+			return false;
+		}
+
+		// u, v and t are kept scaled by |det| until the end, so misses do not pay for the division
+		// sign of det is random per triangle, so it is folded in without branches; same for both sides of the range checks
+		float sign = copysignf(1.0f, det);
+		float absDet = det * sign;
+
+		float sx = origin.x - v0.x, sy = origin.y - v0.y, sz = origin.z - v0.z;
+		float uDet = (sx * px + sy * py + sz * pz) * sign;
+		if (fmaxf(-uDet, uDet - absDet) > 0) {
+			return false;
+		}
+
+		// q = s x e1
+		float qx = sy * e1z - sz * e1y;
+		float qy = sz * e1x - sx * e1z;
+		float qz = sx * e1y - sy * e1x;
+
+		float vDet = (dir.x * qx + dir.y * qy + dir.z * qz) * sign;
+		if (fmaxf(-vDet, uDet + vDet - absDet) > 0) {
+			return false;
+		}
+
+		float invDet = 1 / absDet;
+		t = (e2x * qx + e2y * qy + e2z * qz) * sign * invDet;
+		u = uDet * invDet;
+		v = vDet * invDet;
+
+		// same as reference: only what is in front of line.first, no far limit
+		return t > 0;
+	}
+
+	// return 1 if point is above line, -1 if is below, 0 if is on the line or outside of X axis
+	int overUnderLine(Vec3F& a, Vec3F& b) const{
+		// out of X axis
+		if (a.x < 0 && b.x < 0 || a.x > 0 && b.x > 0) {
+			return 0;
+		}
+
+		// both points are below (Y grows upwards) , so [0,0] is above
+		if (a.y < 0 && b.y < 0) {
+			return 1;
+		}
+
+		// both points are above, so [0,0] is below
+		if (a.y > 0 && b.y > 0) {
+			return -1;
+		}
+
+		// calculate f(0) for line between a and b
+		float lA = (b.y - a.y) / (b.x - a.x);
+		float lB = a.y - lA * a.x;
+
+		if (lB < 0) return 1;  // point [0,0] is above line hiting X
+		if (lB > 0) return -1;
+		return 0;
+	}
+
+	int pairIsOut(Vec3F& a, Vec3F& b) const {
+		if (a.x < 0 && b.x < 0 || a.x > 0 && b.x > 0) {
+			return 1;
+		}
+		else {
+			return 0;
+		}
+	}
+
+	// checks if point [0,0] is inside triangle a,b,c ignoring Z axis ; it will check it for infinite length of trace line, so requires distance check
+	bool hitTriangle(Triangle &t) const {
+		Vec3F& a = t.vertices[0];
+		Vec3F& b = t.vertices[1];
+		Vec3F& c = t.vertices[2];
+		int outOfX = pairIsOut(a,b) + pairIsOut(b,c) + pairIsOut(a,c);
+		if (outOfX == 3) { // it is either 0,1 or 3 for triangle
+			return false;
+		}
+
+		int ab = overUnderLine(a, b);
+		int ac = overUnderLine(a, c);
+		int bc = overUnderLine(b, c);
+
+		int sum = ab + ac + bc;
+
+		// if is out then will reach -2 or 2 or in corner case of sharing X with vertex => -3 or 3
+		return sum >= -1 && sum <= 1;
+	}
+
+	// hit is calculated for point [0,0]; triangle is shifted in Z axis; calculate distance to triangle plain on Z axis
+	float zOffsetFromCenter(const Triangle& t) const {
+		Vec3F n = t.normal();
+		// triangle plain equation is n.x*X + n.y*Y + n.z*Z + D = 0 ;
+		// to calculate D i pick first vertex from triangle, and then for Z it is n.x*0 + n.y*0 + n.z*Z + D = 0 => Z = -D/n.z
+
+		Vec3F v = t.vertices[0];
+		float D = -(n.x*v.x + n.y*v.y + n.z*v.z);
+
+		return -D / n.z;
+	}
+
+	// linear scan over tris
+	bool check() {
+		prepare();
+
+		for (const Triangle& t : tris) {
+			checkTriangle(t, hits);
+		}
+
+		return collectHits();
+	}
+
+	// linear scan over tris split into chunks across pool; each chunk collects own hits, which are merged in chunk order,
+	// so hits are the same as from check(), ties included
+	bool check(ThreadPool& pool) {
+		prepare();
+
+		int count = (int)tris.size();
+		int chunkCount = pool.size() * 4;
+		int chunkSize = (count + chunkCount - 1) / chunkCount;
+		if (chunkSize < MIN_CHUNK) {
+			chunkSize = MIN_CHUNK;
+		}
+		chunkCount = (count + chunkSize - 1) / chunkSize;
+
+		if (chunkHits.size() < (size_t)chunkCount) {
+			chunkHits.resize(chunkCount);
+		}
+
+		pool.run(chunkCount, [&](int chunk) {
+			vector<HitPosition>& local = chunkHits[chunk];
+			local.clear();
+
+			int end = min<int>(count, (chunk + 1) * chunkSize);
+			for (int i = chunk * chunkSize; i < end; ++i) {
+				checkTriangle(tris[i], local);
+			}
+		});
+
+		for (int chunk = 0; chunk < chunkCount; ++chunk) {
+			for (const HitPosition& h : chunkHits[chunk]) {
+				if (h.t < bestT()) {
+					addHit(hits, h);
+				}
+			}
+		}
+
+		return collectHits();
+	}
+
+	// same as check(), but only triangles from leaves of bvh crossed by line are tested; bvh has to be built from scene
+	bool check(const vector<Triangle>& scene, const BVH& bvh) {
+		prepare();
+
+		if (query == HitClosest) {
+			bvh.traverseLeavesNearest(line, [&](int first, int count) {
+				for (int i = first; i < first + count; ++i) {
+					checkTriangle(scene[bvh.order[i]], hits);
+				}
+				return bestT();
+			});
+		}
+		else {
+			bvh.traverse(line, [&](int idx) {
+				checkTriangle(scene[idx], hits);
+			});
+		}
+
+		return collectHits();
+	}
+
+	// Moller-Trumbore over packed triangles with SIMD kernel picked by cpuid, 4 or 8 triangles per step;
+	// hits are the same as check() with HitMollerTrumbore, method is ignored
+	bool check(const TriangleSoA& soa) {
+		prepare();
+
+		soaHits.clear();
+		soa.intersect(0, soa.count, line.first, dir, FLT_MAX, soaHits);
+		addSoAHits(soa);
+
+		return sortHits();
+	}
+
+	// bvh over soa, where soa was packed in bvh.order, so every leaf is one kernel call
+	bool check(const TriangleSoA& soa, const BVH& bvh) {
+		prepare();
+
+		if (query == HitClosest) {
+			bvh.traverseLeavesNearest(line, [&](int first, int count) {
+				soaHits.clear();
+				soa.intersect(first, count, line.first, dir, bestT(), soaHits);
+				addSoAHits(soa);
+				return bestT();
+			});
+		}
+		else {
+			soaHits.clear();
+			bvh.traverseLeaves(line, [&](int first, int count) {
+				soa.intersect(first, count, line.first, dir, FLT_MAX, soaHits);
+			});
+			addSoAHits(soa);
+		}
+
+		return sortHits();
+	}
+
+	// objects from cells of grid crossed by line, nearest cells first; meshOf(id, tris) appends world triangles of an
+	// object. In HitClosest mode walk stops at the first cell which ends beyond the best hit, as any object not tested
+	// yet lies in cells further on.
+	template <typename F> bool check(const SpatialGrid& grid, F meshOf) {
+		prepare();
+
+		// walk lists each object once, in the first cell it is crossed in
+		grid.walkRay(line.first, dir, [&](const vector<int>& ids, float, float tExit) {
+			for (int id : ids) {
+				objectTris.clear();
+				meshOf(id, objectTris);
+				for (const Triangle& t : objectTris) {
+					checkTriangle(t, hits);
+				}
+			}
+
+			return bestT() > tExit;
+		});
+
+		return collectHits();
+	}
+
+private:
+	Vec3F dir;
+	float dirLen;
+	vector<Triangle> objectTris;
+	Vec3F angles;
+	M44F aligned;
+	vector<SoAHit> soaHits;
+	vector<vector<HitPosition>> chunkHits;
+
+	// smaller chunks cost more in wake ups than they save
+	static const int MIN_CHUNK = 4096;
+
+	void prepare() {
+		hits.clear();
+
+		dir = line.second;
+		dir.sub(line.first);
+		dirLen = dir.len();
+
+		if (method == HitReference) {
+			alignToLine();
+		}
+	}
+
+	void alignToLine() {
+		angles = dir.rotationYXZ(Vec3F::UP);
+
+		// Align all objects along 'line' so all calculations are along x,y axises
+		aligned = M44F();
+		aligned.Mult(M44F().asRotateX(-angles.x))
+			.Mult(M44F().asRotateY(-angles.y))
+			.Mult(M44F().asTranslate(-line.first.x, -line.first.y, -line.first.z));
+	}
+
+	// into is hits, or a list local to one worker in parallel check
+	void checkTriangle(const Triangle& t, vector<HitPosition>& into) const {
+		if (method == HitMollerTrumbore) {
+			checkTriangleDirect(t, into);
+		}
+		else {
+			checkTriangleAligned(t, into);
+		}
+	}
+
+	void checkTriangleDirect(const Triangle& tri, vector<HitPosition>& into) const {
+		float t, u, v;
+		if (intersect(line.first, dir, tri, t, u, v) && t < bestT(into)) {
+			Vec3F at = dir;
+			at.mult(t).add(line.first);
+			addHit(into, { tri.id, at, t, u, v });
+		}
+	}
+
+	void checkTriangleAligned(const Triangle& t, vector<HitPosition>& into) const {
+		Vec3F a = aligned.ApplyOnPoint(t.vertices[0]);
+		Vec3F b = aligned.ApplyOnPoint(t.vertices[1]);
+		Vec3F c = aligned.ApplyOnPoint(t.vertices[2]);
+
+		Triangle mT = { t.id, {a,b,c} };
+
+		if (hitTriangle(mT)) {
+			float offsetZ = zOffsetFromCenter(mT);
+
+			// distance > 0 means that triange is BEHIND (we look in direction [0,0,-1] axis)
+			if (offsetZ < 0) {
+				addHit(into, { t.id, {0,0,offsetZ }, -offsetZ / dirLen, 0, 0 });
+			}
+		}
+	}
+
+	// in HitClosest mode hits holds at most one entry - the best so far; it is still in aligned space for HitReference,
+	// so only the winner is transformed back in collectHits
+	void addHit(vector<HitPosition>& into, const HitPosition& h) const {
+		if (query == HitAll || into.empty()) {
+			into.push_back(h);
+		}
+		else if (h.t < into[0].t) {
+			into[0] = h;
+		}
+	}
+
+	float bestT(const vector<HitPosition>& of) const {
+		return query == HitClosest && !of.empty() ? of[0].t : FLT_MAX;
+	}
+
+	float bestT() const {
+		return bestT(hits);
+	}
+
+	void addSoAHits(const TriangleSoA& soa) {
+		for (const SoAHit& each : soaHits) {
+			if (each.t >= bestT()) {
+				continue;
+			}
+
+			Vec3F at = dir;
+			at.mult(each.t).add(line.first);
+			addHit(hits, { soa.ids[each.index], at, each.t, each.u, each.v });
+		}
+	}
+
+	bool sortHits() {
+		if (hits.empty()) {
+			return false;
+		}
+
+		sort(hits.begin(), hits.end(), HitPosition::Ordered);
+		return true;
+	}
+
+	bool collectHits() {
+		if (hits.size() != 0) {
+			sort(hits.begin(), hits.end(), HitPosition::Ordered);
+
+			if (method == HitMollerTrumbore) {
+				// already in world space
+				return true;
+			}
+
+			// figure out the strategy for multiple hits if triangle should hold it or ordered set of all handlers should decide if it passes or not
+
+			M44F revM;
+			revM.Mult(M44F().asTranslate(line.first.x, line.first.y, line.first.z))
+				.Mult(M44F().asRotateY(angles.y))
+				.Mult(M44F().asRotateX(angles.x));
+
+
+			for (HitPosition& t : hits) {
+				t.v = revM.ApplyOnPoint(t.v);
+			}
+
+			return true;
+		}
+		else {
+			return false;
+		}
+	}
+};
+
+// Many rays at once, e.g. a grid sampled over a screen rectangle for area selection.
+// Rays are taken in packets of PACKET consecutive entries, so neighbouring rays (a small tile of pixels) should be next to each other.
+// Each packet walks the bvh once: a node is entered when any ray still active for it hits its box, and every ray keeps its own closest hit.
+struct PacketHitTest {
+	static const int PACKET = 16;
+
+	vector<Line> rays;
+	vector<int> closestIds;		// per ray, id of nearest hit or -1
+	vector<float> closestT;
+	vector<int> ids;			// unique ids hit by any ray, ascending
+
+	int nodesVisited = 0;
+
+	// soa has to be packed in bvh.order
+	bool check(const TriangleSoA& soa, const BVH& bvh) {
+		int count = (int)rays.size();
+
+		closestIds.assign(count, -1);
+		closestT.assign(count, FLT_MAX);
+		ids.clear();
+		nodesVisited = 0;
+
+		if (count == 0 || bvh.empty()) {
+			return false;
+		}
+
+		dirs.resize(count);
+		invDirs.resize(count);
+		for (int r = 0; r < count; ++r) {
+			dirs[r] = rays[r].second;
+			dirs[r].sub(rays[r].first);
+			invDirs[r] = BVH::inverseDir(dirs[r]);
+		}
+
+		for (int first = 0; first < count; first += PACKET) {
+			checkPacket(soa, bvh, first, first + PACKET < count ? first + PACKET : count);
+		}
+
+		for (int id : closestIds) {
+			if (id != -1) {
+				ids.push_back(id);
+			}
+		}
+
+		sort(ids.begin(), ids.end());
+		ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+		return !ids.empty();
+	}
+
+private:
+	vector<Vec3F> dirs;
+	vector<Vec3F> invDirs;
+	vector<SoAHit> soaHits;
+
+	void checkPacket(const TriangleSoA& soa, const BVH& bvh, int begin, int end) {
+		// each entry remembers first ray which may still hit the node; rays before it already missed one of its ancestors
+		struct Pending {
+			int node;
+			int firstActive;
+		} stack[64];
+
+		int top = 0;
+		stack[top++] = { 0, begin };
+
+		while (top > 0) {
+			Pending p = stack[--top];
+			const BVHNode& n = bvh.nodes[p.node];
+			++nodesVisited;
+
+			int first = firstHitting(n.bounds, p.firstActive, end);
+			if (first == end) {
+				continue;
+			}
+
+			if (n.count) {
+				for (int r = first; r < end; ++r) {
+					// box test is much cheaper than a leaf of triangles, and rays after first may well miss it
+					if (r != first && !n.bounds.hitRay(rays[r].first, invDirs[r], closestT[r])) {
+						continue;
+					}
+
+					soaHits.clear();
+					soa.intersect(n.first, n.count, rays[r].first, dirs[r], closestT[r], soaHits);
+
+					for (const SoAHit& each : soaHits) {
+						if (each.t < closestT[r]) {
+							closestT[r] = each.t;
+							closestIds[r] = soa.ids[each.index];
+						}
+					}
+				}
+				continue;
+			}
+
+			// order children by first active ray, which stands for the whole packet when rays are coherent
+			float tLeft, tRight;
+			bool left = bvh.nodes[n.first].bounds.hitRay(rays[first].first, invDirs[first], FLT_MAX, tLeft);
+			bool right = bvh.nodes[n.first + 1].bounds.hitRay(rays[first].first, invDirs[first], FLT_MAX, tRight);
+			bool leftFirst = left && (!right || tLeft <= tRight);
+
+			stack[top++] = { leftFirst ? n.first + 1 : n.first, first };
+			stack[top++] = { leftFirst ? n.first : n.first + 1, first };
+		}
+	}
+
+	int firstHitting(const AABB& bounds, int from, int end) const {
+		for (int r = from; r < end; ++r) {
+			if (bounds.hitRay(rays[r].first, invDirs[r], closestT[r])) {
+				return r;
+			}
+		}
+
+		return end;
+	}
+};
@@ -1,16 +1,115 @@
 #pragma once
 
 #include <string>
-#include <list>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdarg>
 using namespace std;
 
+enum LogLevel {
+	LogDebug,
+	LogInfo,
+	LogWarning,
+	LogError,
+};
+
+// arguments are checked against format where the compiler can do it
+#if defined(__GNUC__)
+#define LOG_FORMAT(formatAt) __attribute__((format(printf, formatAt, formatAt + 1)))
+#else
+#define LOG_FORMAT(formatAt)
+#endif
+
+// debug lines cost nothing unless built with EXPLORER3D_DEBUG_LOG; arguments are not even evaluated
+#ifdef EXPLORER3D_DEBUG_LOG
+#define LOG_DEBUG(...) Log.printfAt(LogDebug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+// Last CAPACITY lines logged, in a ring of preallocated slots; older lines are overwritten. Any thread may printf at
+// the same time without locks: a line is formatted on the stack of its thread, takes a line number with one atomic
+// increment and claims its slot by moving the stamp from a published line to "being written" with a CAS. A slot still
+// being written by a writer one lap behind is not taken; the line is dropped and marked so in the slot, as if it was
+// overwritten. Readers skip slots which are being written or changed while they copied them.
+// Nothing is written out on the logging thread: stdout (echo) and spill file get lines in batches from flush(), which
+// the writer thread calls every few ms once started; lines overwritten before that are counted in a note.
 struct MessageLog {
-	list<string> history;
-	char buffer[120] = {};
-	int unreadMessages = 0;
+	static const int CAPACITY = 1024;
+	static const int LINE_SIZE = 120;	// with terminating 0; longer lines go on in the next slot
+	static const int MAX_UNREAD = 10;
+
+	struct Slot {
+		atomic<long long> stamp;	// 2n+1 while line n is written, 2n+2 once it is there
+		atomic<long long> dropped;	// last line number dropped on this slot, -1 for none
+		char text[LINE_SIZE];
+	};
+
+	atomic<int> unreadMessages;
+	atomic<int> minLevel;	// lines below it are dropped before formatting; LogInfo by default
+	bool echo = true;		// flush() writes lines to stdout
+
+#ifdef EXPLORER3D_TEST_HOOKS
+	// called with the line number after a slot is claimed and before text is copied in; lets bench stall a writer there
+	void (*claimedHook)(long long n) = nullptr;
+#endif
+
+	MessageLog();
+	~MessageLog();
+
+	MessageLog(const MessageLog&) = delete;
+	MessageLog& operator=(const MessageLog&) = delete;
+
+	// LogInfo; format positions count this as first argument
+	void printf(const char* format, ...) LOG_FORMAT(2);
+	void printfAt(LogLevel level, const char* format, ...) LOG_FORMAT(3);
+
+	// count newest lines into lines, oldest first; strings are reused. Lines overwritten or not finished while read are
+	// left out, so fewer may come back; returns how many
+	int last(int count, vector<string>& lines) const;
 
-	void printf(const char* format, ...);
+	// lines logged so far, overwritten ones included
+	long long written() const {
+		return next.load(memory_order_acquire);
+	}
+
+	// flush() also appends lines to file at path, starting with those not flushed yet; false when it cannot be opened
+	bool spillTo(const char* path);
+
+	// lines logged since previous flush go to stdout and spill file, one write each
+	void flush();
+
+	// background thread flushing every intervalMs, or sooner when the ring fills up; stopped and flushed by stopWriter
+	void startWriter(int intervalMs = 10);
+	void stopWriter();
+
+private:
+	Slot slots[CAPACITY];
+	atomic<long long> next;
+
+	mutex flushLock;	// taken only by flushing threads, never by printf
+	FILE* spillFile = nullptr;
+	long long flushed = 0;
+	string batch;
+	string line;
+
+	thread writer;
+	mutex writerLock;
+	condition_variable writerWake;
+	bool writerStopping = false;
+
+	void vprintfAt(LogLevel level, const char* format, va_list args);
+	void addLine(const char* text, size_t length);
+
+	// slot of line n marked as being written by it; false when it is held by another writer and line n is dropped
+	bool claimSlot(long long n);
+
+	// copy of line n into out, if it is still in its slot
+	bool readLine(long long n, string& out) const;
 };
 
 extern MessageLog Log;
-
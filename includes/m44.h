@@ -1,8 +1,18 @@
 #pragma once
+#include <cmath>
 #include <trig.h>
+#include <log.h>
+#include <simd.h>
 
+#if defined(EXPLORER_X86)
+#include <emmintrin.h>
+#elif defined(EXPLORER_NEON)
+#include <arm_neon.h>
+#endif
+
+// column major, as glMultMatrixf expects: m[column][row]
 template <typename T> struct M44 {
-	T m[4][4] = { 1,0,0,0, 0,1,0,0 , 0,0,1,0, 0,0,0,1 };
+	alignas(16) T m[4][4] = { 1,0,0,0, 0,1,0,0 , 0,0,1,0, 0,0,0,1 };
 
 	T* ptr() const {
 		return (T*)m;
@@ -41,13 +51,49 @@ template <typename T> struct M44 {
 		return *this;
 	}
 
-	void FillFrom(M44& s) {
+	// translate * rotZ * rotX * rotY * scale in one pass, same as chaining asTranslate, asRotateZ, asRotateX, asRotateY
+	// and asScale with Mult, but with sin/cos of each angle taken once and no 4x4 products; angles in radians
+	M44& asTRS(const Vec3F& t, const Vec3F& angle, const Vec3F& s) {
+		T sx = sin(angle.x), cx = cos(angle.x);
+		T sy = sin(angle.y), cy = cos(angle.y);
+		T sz = sin(angle.z), cz = cos(angle.z);
+
+		// rotZ * rotX * rotY, written out; m[column][row]
+		m[0][0] = (cz * cy - sz * sx * sy) * s.x;
+		m[0][1] = (sz * cy + cz * sx * sy) * s.x;
+		m[0][2] = -cx * sy * s.x;
+		m[0][3] = 0;
+
+		m[1][0] = -sz * cx * s.y;
+		m[1][1] = cz * cx * s.y;
+		m[1][2] = sx * s.y;
+		m[1][3] = 0;
+
+		m[2][0] = (cz * sy + sz * sx * cy) * s.z;
+		m[2][1] = (sz * sy - cz * sx * cy) * s.z;
+		m[2][2] = cx * cy * s.z;
+		m[2][3] = 0;
+
+		m[3][0] = t.x;
+		m[3][1] = t.y;
+		m[3][2] = t.z;
+		m[3][3] = 1;
+
+		return *this;
+	}
+
+	void FillFrom(const M44& s) {
 		for (int y = 0; y < 4; ++y)
 			for (int x = 0; x < 4; ++x)
 				m[y][x] = s.m[y][x];
 	}
 
-	M44& Mult(M44& o) {
+	// this = this * o; M44<float> has a SIMD version below
+	M44& Mult(const M44& o) {
+		return MultScalar(o);
+	}
+
+	M44& MultScalar(const M44& o) {
 		M44 r;
 		for (int l = 0; l < 4; ++l) {
 			r.m[0][l] = m[0][l] * o.m[0][0] + m[1][l] * o.m[0][1] + m[2][l] * o.m[0][2] + m[3][l] * o.m[0][3];
@@ -60,11 +106,17 @@ template <typename T> struct M44 {
 		return *this;
 	}
 
+	// debug level; compiled out unless EXPLORER3D_DEBUG_LOG
 	void Print() const {
-		Log.printf("[ %f\t%f\t%f\t%f ]\n", m[0][0], m[1][0], m[2][0], m[3][0]);
-		Log.printf("[ %f\t%f\t%f\t%f ]\n", m[0][1], m[1][1], m[2][1], m[3][1]);
-		Log.printf("[ %f\t%f\t%f\t%f ]\n", m[0][2], m[1][2], m[2][2], m[3][2]);
-		Log.printf("[ %f\t%f\t%f\t%f ]\n", m[0][3], m[1][3], m[2][3], m[3][3]);
+		LOG_DEBUG(
+			"[ %f\t%f\t%f\t%f ]\n"
+			"[ %f\t%f\t%f\t%f ]\n"
+			"[ %f\t%f\t%f\t%f ]\n"
+			"[ %f\t%f\t%f\t%f ]\n",
+			m[0][0], m[1][0], m[2][0], m[3][0],
+			m[0][1], m[1][1], m[2][1], m[3][1],
+			m[0][2], m[1][2], m[2][2], m[3][2],
+			m[0][3], m[1][3], m[2][3], m[3][3]);
 	}
 
 	Vec3F ApplyOnPoint(const Vec3F& p) const {
@@ -75,6 +127,95 @@ template <typename T> struct M44 {
 		return Vec3F{ nX , nY, nZ };
 	}
 
+	// out[i] = ApplyOnPoint(in[i]); in and out may be the same array
+	void ApplyOnPoints(const Vec3F* in, Vec3F* out, int n) const {
+		ApplyOnPointsScalar(in, out, n);
+	}
+
+	void ApplyOnPointsScalar(const Vec3F* in, Vec3F* out, int n) const {
+		for (int i = 0; i < n; ++i) {
+			out[i] = ApplyOnPoint(in[i]);
+		}
+	}
 };
 
+// SIMD versions keep the order of operations of the scalar ones (multiply, then add left to right, no fused multiply-add),
+// so results are equal to the last bit
+
+#if defined(EXPLORER_X86)
+
+// column c of this * o is sum over k of column k of this, times o.m[c][k]
+template <> inline M44<float>& M44<float>::Mult(const M44<float>& o) {
+	__m128 c0 = _mm_loadu_ps(m[0]), c1 = _mm_loadu_ps(m[1]), c2 = _mm_loadu_ps(m[2]), c3 = _mm_loadu_ps(m[3]);
+
+	__m128 r[4];
+	for (int c = 0; c < 4; ++c) {
+		__m128 acc = _mm_mul_ps(c0, _mm_set1_ps(o.m[c][0]));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_set1_ps(o.m[c][1])));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_set1_ps(o.m[c][2])));
+		r[c] = _mm_add_ps(acc, _mm_mul_ps(c3, _mm_set1_ps(o.m[c][3])));
+	}
+
+	// o may be this, so nothing is stored before all columns are done
+	for (int c = 0; c < 4; ++c) {
+		_mm_storeu_ps(m[c], r[c]);
+	}
+
+	return *this;
+}
+
+// ApplyOnPoints stays scalar on x86: compilers already turn the scalar loop into 2-wide SSE, and a 4-wide version spends
+// more on shuffling x/y/z of Vec3F arrays into lanes and back than it saves (measured with Explorer3DBench)
+
+#elif defined(EXPLORER_NEON)
+
+template <> inline M44<float>& M44<float>::Mult(const M44<float>& o) {
+	float32x4_t c0 = vld1q_f32(m[0]), c1 = vld1q_f32(m[1]), c2 = vld1q_f32(m[2]), c3 = vld1q_f32(m[3]);
+
+	float32x4_t r[4];
+	for (int c = 0; c < 4; ++c) {
+		float32x4_t acc = vmulq_n_f32(c0, o.m[c][0]);
+		acc = vaddq_f32(acc, vmulq_n_f32(c1, o.m[c][1]));
+		acc = vaddq_f32(acc, vmulq_n_f32(c2, o.m[c][2]));
+		r[c] = vaddq_f32(acc, vmulq_n_f32(c3, o.m[c][3]));
+	}
+
+	for (int c = 0; c < 4; ++c) {
+		vst1q_f32(m[c], r[c]);
+	}
+
+	return *this;
+}
+
+// vld3q/vst3q split x/y/z of 4 points into lanes and interleave them back, without extra shuffles
+template <> inline void M44<float>::ApplyOnPoints(const Vec3F* in, Vec3F* out, int n) const {
+	float32x4_t coef[4][3];
+	for (int c = 0; c < 4; ++c) {
+		for (int row = 0; row < 3; ++row) {
+			coef[c][row] = vdupq_n_f32(m[c][row]);
+		}
+	}
+
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		float32x4x3_t p = vld3q_f32(&in[i].x);
+
+		float32x4x3_t r;
+		for (int row = 0; row < 3; ++row) {
+			float32x4_t acc = vmulq_f32(coef[0][row], p.val[0]);
+			acc = vaddq_f32(acc, vmulq_f32(coef[1][row], p.val[1]));
+			acc = vaddq_f32(acc, vmulq_f32(coef[2][row], p.val[2]));
+			r.val[row] = vaddq_f32(acc, coef[3][row]);
+		}
+
+		vst3q_f32(&out[i].x, r);
+	}
+
+	for (; i < n; ++i) {
+		out[i] = ApplyOnPoint(in[i]);
+	}
+}
+
+#endif
+
 typedef M44<float> M44F;
\ No newline at end of file
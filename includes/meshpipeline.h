@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <geometry.h>
+
+using namespace std;
+
+// Vertices of an indexed mesh transformed once and kept as separate x/y/z arrays (structure of arrays), so the loop
+// vectorizes; triangles are expanded from indices afterwards, and a vertex shared by several faces is not transformed again.
+template <int N> struct TransformedVertices {
+	float x[N];
+	float y[N];
+	float z[N];
+
+	// vertices are N xyz triples; same arithmetic as M44::ApplyOnPoint, so results are equal to transforming each triangle
+	void transform(const M44F& m, const float* vertices) {
+		for (int i = 0; i < N; ++i) {
+			float vx = vertices[i * 3 + 0];
+			float vy = vertices[i * 3 + 1];
+			float vz = vertices[i * 3 + 2];
+
+			x[i] = m.m[0][0] * vx + m.m[1][0] * vy + m.m[2][0] * vz + m.m[3][0];
+			y[i] = m.m[0][1] * vx + m.m[1][1] * vy + m.m[2][1] * vz + m.m[3][1];
+			z[i] = m.m[0][2] * vx + m.m[1][2] * vy + m.m[2][2] * vz + m.m[3][2];
+		}
+	}
+
+	Vec3F at(int i) const {
+		return { x[i], y[i], z[i] };
+	}
+
+	// indices holds 3 per triangle; fill grows once for all of them
+	void emitTriangles(int id, const unsigned int* indices, int triangleCount, vector<Triangle>& fill) const {
+		size_t first = fill.size();
+		fill.resize(first + triangleCount);
+		Triangle* out = fill.data() + first;
+
+		for (int t = 0; t < triangleCount; ++t) {
+			const unsigned int* idx = indices + t * 3;
+			out[t].id = id;
+			for (int k = 0; k < 3; ++k) {
+				out[t].vertices[k] = at(idx[k]);
+			}
+		}
+	}
+
+	// xyz per vertex, as glVertexPointer takes it
+	void interleave(float* out) const {
+		for (int i = 0; i < N; ++i) {
+			out[i * 3 + 0] = x[i];
+			out[i * 3 + 1] = y[i];
+			out[i * 3 + 2] = z[i];
+		}
+	}
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <textmesh.h>
+#include <ui.h>
+
+using namespace std;
+
+// draw calls and GL state switches (texturing, texture binds) spent on one frame of overlay; filled by the renderer
+struct OverlayStats {
+	int drawCalls = 0;
+	int stateChanges = 0;
+};
+
+// whole 2D overlay of a frame collected into one vertex array, so it is uploaded once and drawn in a few calls. Vertices
+// are kept apart by kind and put one after another by finish(): untextured quads, then lines, then font atlas quads.
+// Kinds later in that order are drawn on top, which is how UIRect stacks background, border and label.
+struct OverlayBatch {
+	enum Kind {
+		OverlayFill,
+		OverlayLines,
+		OverlayGlyphs,
+		OVERLAY_KINDS,
+	};
+
+	vector<TextVertex> collected[OVERLAY_KINDS];
+
+	vector<TextVertex> vertices;	// all kinds, after finish()
+	int first[OVERLAY_KINDS] = {};
+	int count[OVERLAY_KINDS] = {};
+
+	OverlayStats stats;
+
+	// memory is kept for the next frame
+	void clear();
+
+	// w x h rectangle at x, y; c.top along its upper edge, c.bottom along the lower one
+	void addQuad(float x, float y, float w, float h, const UIFillRGB& c);
+
+	// outline of the same rectangle, as 4 lines
+	void addFrame(float x, float y, float w, float h, const UIFillRGB& c);
+
+	// glyphs of mesh moved to x, y
+	void addText(const TextMesh& mesh, float x, float y);
+
+	void finish();
+
+	int size() const {
+		return (int)vertices.size();
+	}
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <cmath>
+#include <trig.h>
+#include <m44.h>
+
+// how Camera and CubeShape keep their rotation: Euler angles in degrees (angle), or a quaternion (orientation)
+enum OrientationMode {
+	OrientationEuler,
+	OrientationQuat,
+};
+
+// unit quaternion; composes like M44 (this = this * o, so o is applied first) and becomes M44 only when GL needs it
+struct Quat {
+	float w = 1;
+	float x = 0;
+	float y = 0;
+	float z = 0;
+
+	// axis has to be of length 1
+	static Quat axisAngle(const Vec3F& axis, float radians) {
+		float s = sinf(radians / 2);
+		return { cosf(radians / 2), axis.x * s, axis.y * s, axis.z * s };
+	}
+
+	static Quat rotateX(float radians) {
+		return { cosf(radians / 2), sinf(radians / 2), 0, 0 };
+	}
+
+	static Quat rotateY(float radians) {
+		return { cosf(radians / 2), 0, sinf(radians / 2), 0 };
+	}
+
+	static Quat rotateZ(float radians) {
+		return { cosf(radians / 2), 0, 0, sinf(radians / 2) };
+	}
+
+	// rotY * rotX * rotZ, order of Camera angles; radians
+	static Quat fromYXZ(const Vec3F& angle) {
+		return rotateY(angle.y).Mult(rotateX(angle.x)).Mult(rotateZ(angle.z));
+	}
+
+	// rotZ * rotX * rotY, order of CubeShape angles; radians
+	static Quat fromZXY(const Vec3F& angle) {
+		return rotateZ(angle.z).Mult(rotateX(angle.x)).Mult(rotateY(angle.y));
+	}
+
+	Quat& Mult(const Quat& o) {
+		Quat r = {
+			w * o.w - x * o.x - y * o.y - z * o.z,
+			w * o.x + x * o.w + y * o.z - z * o.y,
+			w * o.y - x * o.z + y * o.w + z * o.x,
+			w * o.z + x * o.y - y * o.x + z * o.w
+		};
+
+		*this = r;
+		return *this;
+	}
+
+	// inverse rotation, for unit quaternion
+	Quat conjugate() const {
+		return { w, -x, -y, -z };
+	}
+
+	// keeps repeated Mult from drifting away from unit length
+	Quat& normalize() {
+		float l = sqrtf(w * w + x * x + y * y + z * z);
+		w /= l; x /= l; y /= l; z /= l;
+		return *this;
+	}
+
+	// p + 2w(v x p) + 2v x (v x p), where v = x,y,z
+	Vec3F ApplyOnPoint(const Vec3F& p) const {
+		float tx = 2 * (y * p.z - z * p.y);
+		float ty = 2 * (z * p.x - x * p.z);
+		float tz = 2 * (x * p.y - y * p.x);
+
+		return {
+			p.x + w * tx + (y * tz - z * ty),
+			p.y + w * ty + (z * tx - x * tz),
+			p.z + w * tz + (x * ty - y * tx)
+		};
+	}
+
+	M44F asM44() const {
+		return asTRS({ 0,0,0 }, { 1,1,1 });
+	}
+
+	// translate * this * scale, as M44::asTRS does with Euler angles
+	M44F asTRS(const Vec3F& t, const Vec3F& s) const {
+		float xx = x * x, yy = y * y, zz = z * z;
+		float xy = x * y, xz = x * z, yz = y * z;
+		float wx = w * x, wy = w * y, wz = w * z;
+
+		M44F m;
+		m.m[0][0] = (1 - 2 * (yy + zz)) * s.x;
+		m.m[0][1] = 2 * (xy + wz) * s.x;
+		m.m[0][2] = 2 * (xz - wy) * s.x;
+
+		m.m[1][0] = 2 * (xy - wz) * s.y;
+		m.m[1][1] = (1 - 2 * (xx + zz)) * s.y;
+		m.m[1][2] = 2 * (yz + wx) * s.y;
+
+		m.m[2][0] = 2 * (xz + wy) * s.z;
+		m.m[2][1] = 2 * (yz - wx) * s.z;
+		m.m[2][2] = (1 - 2 * (xx + yy)) * s.z;
+
+		m.m[3][0] = t.x;
+		m.m[3][1] = t.y;
+		m.m[3][2] = t.z;
+
+		return m;
+	}
+
+	// Camera angles (Y, X, Z order) in radians, from where forward and up end up; only for display and leaving quaternion mode
+	Vec3F anglesYXZ() const {
+		return ApplyOnPoint({ 0,0,-1 }).rotationYXZ(ApplyOnPoint({ 0,1,0 }));
+	}
+};
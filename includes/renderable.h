@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <geometry.h>
+#include <bvh.h>
+#include <cubebatch.h>
+
+using namespace std;
+
+struct Renderable {
+	// bumped on every pos/angle/scale change, so cached world triangles (SceneMesh) know they are stale
+	unsigned int version = 0;
+
+	void transformChanged() {
+		++version;
+	}
+
+	virtual ~Renderable() {}
+
+	// given by SceneStore; triangles from mesh() carry it, so picking can tell what was hit
+	int id = 0;
+
+	int getId() const {
+		return id;
+	}
+
+	virtual void mesh(vector<Triangle>& fill) const = 0;
+	virtual void render(int frames) const = 0;
+	virtual void toggleSelect() = 0;
+
+	// world box, for SpatialGrid; this one meshes, objects which know their box cheaper should override it
+	virtual AABB bounds() const {
+		vector<Triangle> tris;
+		mesh(tris);
+
+		AABB b;
+		for (const Triangle& t : tris) {
+			for (const Vec3F& v : t.vertices) {
+				b.grow(v);
+			}
+		}
+		return b;
+	}
+
+	// adds itself to batch drawn for the whole frame instead of render(); false when it has to be drawn on its own
+	virtual bool addToBatch(CubeBatch&) const {
+		return false;
+	}
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <geometry.h>
+#include <bvh.h>
+#include <trisoa.h>
+#include <renderable.h>
+#include <scenestore.h>
+
+using namespace std;
+
+// World space triangles of all renderables, kept between frames together with bvh over them.
+// Renderable is meshed again only when its version changed; then its triangles are overwritten in place and bvh refitted.
+// Adding renderables at the end appends their triangles, anything else (removal, reorder, different triangle count) rebuilds all.
+// With SceneStore, its cubes come first (12 triangles each, in cube order) and its renderables after them; adding or removing
+// a cube rebuilds all.
+struct SceneMesh {
+	struct Entry {
+		const Renderable* renderable;
+		unsigned int version;
+		int first;
+		int count;
+	};
+
+	vector<Entry> entries;
+	vector<Triangle> tris;
+	BVH bvh;
+	TriangleSoA soa;	// tris packed in bvh.order, for SIMD picking
+
+	int rebuilds = 0;
+	int refits = 0;
+
+	// returns true if anything was meshed again
+	bool update(const vector<shared_ptr<Renderable>>& renderables);
+	bool update(const SceneStore& store);
+	void clear();
+
+private:
+	struct Range {
+		int first;
+		int count;
+	};
+
+	vector<Triangle> scratch;
+	vector<Range> moved;
+
+	const SceneStore* meshedStore = nullptr;
+	unsigned int storeLayout = 0;
+	vector<unsigned int> cubeVersions;
+
+	bool update(const SceneStore* store, const vector<shared_ptr<Renderable>>& renderables);
+	void remeshCubes(const SceneStore& store);
+	bool remeshEntries();
+	void append(const Renderable* r);
+	bool sameLayout(const vector<shared_ptr<Renderable>>& renderables, size_t count) const;
+};
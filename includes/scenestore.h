@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <geometry.h>
+#include <cubeshape.h>
+#include <cubebatch.h>
+#include <renderable.h>
+#include <slotmap.h>
+#include <spatialgrid.h>
+
+using namespace std;
+
+// Scene objects kept by component: cubes live in parallel arrays (index i of each belongs to the same cube), so frame
+// preparation and meshing walk contiguous memory without virtual calls or one heap object per cube.
+// Anything which is not a cube comes in through Renderable and is kept as before.
+// Every object gets its id here; removal moves the last one of its kind into the hole, so arrays stay packed.
+struct SceneStore {
+	// where the object of an id is kept
+	struct Location {
+		bool cube;
+		int index;
+	};
+
+	SlotMap<Location> handles;
+
+	vector<int> ids;
+	vector<CubeShape> shapes;		// placement; transform changes go through moveCube/rotateCube/scaleCube/orientCube
+	vector<M44F> models;			// model matrix of each shape, rebuilt on every change
+	vector<unsigned int> versions;	// bumped on every change, as Renderable::version
+	vector<unsigned char> selected;	// drawn with wireframe
+
+	vector<shared_ptr<Renderable>> renderables;
+	vector<unsigned int> renderableVersions;	// version each renderable had when its box went into grid
+
+	// world boxes of all objects by id; cubes are kept up to date as they change, renderables by syncBounds()
+	SpatialGrid grid;
+
+	// bumped when cubes are added or any object is removed, so whoever keeps per object data knows indices moved
+	unsigned int layout = 0;
+
+	int cubeCount() const {
+		return (int)ids.size();
+	}
+
+	int objectCount() const {
+		return cubeCount() + (int)renderables.size();
+	}
+
+	// both return id given to the object, or -1 when SlotMap has no room left and nothing is added; id of c is overwritten
+	int addCube(const CubeShape& c);
+	int addRenderable(const shared_ptr<Renderable>& r);
+
+	// false when id is not in the scene (anymore)
+	bool remove(int id);
+	void clear();
+
+	void moveCube(int index, const Vec3F& pos);
+	void rotateCube(int index, const Vec3F& angle);
+	void scaleCube(int index, const Vec3F& scale);
+	void orientCube(int index, const Quat& orientation);
+
+	// index of cube, or -1 when id is not a cube
+	int cubeForId(int id) const;
+	// nullptr when id is not a renderable
+	Renderable* renderableForId(int id) const;
+
+	// selection of cube or renderable with this id; false when there is none
+	bool toggleSelect(int id);
+
+	// renderables which changed since last call get their box moved in grid
+	void syncBounds();
+
+	// cubes straight into batch, renderables through addToBatch; the ones which refuse land in unbatched
+	void batch(CubeBatch& batch, vector<const Renderable*>& unbatched) const;
+	// same, only for objects with given ids (as from grid queries)
+	void batch(CubeBatch& batch, vector<const Renderable*>& unbatched, const vector<int>& objectIds) const;
+
+	// 12 triangles per cube, in cube order
+	void meshCubes(vector<Triangle>& fill) const;
+	void meshCube(int index, vector<Triangle>& fill) const;
+	// world triangles of cube or renderable with this id
+	void meshObject(int id, vector<Triangle>& fill) const;
+
+private:
+	void cubeChanged(int index);
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+// which vector instruction set intrinsics can be used in this build
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define EXPLORER_X86 1
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define EXPLORER_NEON 1
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+
+using namespace std;
+
+// Stable ids for objects kept in dense arrays; up to 1M of them at once. Id packs slot and its generation into a positive
+// int; slot holds a T (usually index in dense arrays), which owner updates when it moves objects around. Removed slot is
+// reused with next generation, so an old id does not find whatever took its place; generation has 11 bits, so an id
+// comes back after its slot was reused 1024 times. Ids are never 0 nor -1.
+template <typename T> struct SlotMap {
+	static const int SLOT_BITS = 20;
+	static const int SLOT_MASK = (1 << SLOT_BITS) - 1;
+	static const int GENERATION_MASK = (1 << (31 - SLOT_BITS)) - 1;
+	static const int MAX_SLOTS = SLOT_MASK + 1;
+
+	vector<T> values;
+	vector<int> generations;	// of each slot, odd when slot is taken
+	vector<int> freeSlots;
+
+	// -1 when all MAX_SLOTS are taken
+	int insert(const T& value) {
+		int slot;
+		if (freeSlots.empty()) {
+			if ((int)values.size() == MAX_SLOTS) {
+				return -1;
+			}
+
+			slot = (int)values.size();
+			values.push_back(value);
+			generations.push_back(1);
+		}
+		else {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+			values[slot] = value;
+			generations[slot] = (generations[slot] + 1) & GENERATION_MASK;
+		}
+
+		return (generations[slot] << SLOT_BITS) | slot;
+	}
+
+	bool contains(int id) const {
+		int slot = id & SLOT_MASK;
+		return id > 0 && slot < (int)values.size() && generations[slot] == (id >> SLOT_BITS);
+	}
+
+	// nullptr for removed or unknown id
+	T* find(int id) {
+		return contains(id) ? &values[id & SLOT_MASK] : nullptr;
+	}
+
+	const T* find(int id) const {
+		return contains(id) ? &values[id & SLOT_MASK] : nullptr;
+	}
+
+	bool remove(int id) {
+		if (!contains(id)) {
+			return false;
+		}
+
+		int slot = id & SLOT_MASK;
+		generations[slot] = (generations[slot] + 1) & GENERATION_MASK;
+		freeSlots.push_back(slot);
+		return true;
+	}
+
+	void clear() {
+		for (int slot = 0; slot < (int)values.size(); ++slot) {
+			if (generations[slot] & 1) {
+				remove((generations[slot] << SLOT_BITS) | slot);
+			}
+		}
+	}
+};
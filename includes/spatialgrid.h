@@ -0,0 +1,220 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <geometry.h>
+#include <bvh.h>
+#include <frustum.h>
+
+using namespace std;
+
+// Hashed uniform grid over object boxes, objects given by id. Object is listed (by its index in entries) in every cell
+// its box touches; cells are kept in a hash map by cell coordinates, so scene needs no bounds upfront. Insert, remove and move touch only cells
+// of that object, so cost of upkeep and queries follows what is near, not scene size. Objects touching more than
+// MAX_ENTRY_CELLS cells are listed in large instead, which every query looks through; empty boxes are in no list.
+struct SpatialGrid {
+	struct CellRange {
+		int lo[3];
+		int hi[3];
+
+		bool operator==(const CellRange& o) const {
+			return lo[0] == o.lo[0] && lo[1] == o.lo[1] && lo[2] == o.lo[2] && hi[0] == o.hi[0] && hi[1] == o.hi[1] && hi[2] == o.hi[2];
+		}
+
+		bool contains(int x, int y, int z) const {
+			return x >= lo[0] && x <= hi[0] && y >= lo[1] && y <= hi[1] && z >= lo[2] && z <= hi[2];
+		}
+
+		// 0 for a range with hi below lo
+		long long volume() const {
+			if (hi[0] < lo[0] || hi[1] < lo[1] || hi[2] < lo[2]) {
+				return 0;
+			}
+			return (long long)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+		}
+	};
+
+	struct Entry {
+		int id;
+		AABB box;
+		CellRange cells;
+		vector<int> at;	// position in list of each of its cells, x major as they are walked; removal swaps the last one in
+		int largeAt;	// position in large, -1 when not there
+	};
+
+	static const int MAX_ENTRY_CELLS = 4096;
+	// cell coordinates are clamped to +-CELL_LIMIT, so boxes far out share the outermost cells instead of wrapping keys
+	static const int CELL_LIMIT = 1 << 19;
+
+	float cellSize;
+	unordered_map<long long, vector<int>> cells;	// indices into entries
+	vector<Entry> entries;				// dense, in no particular order; queries over most of the scene go through it
+	vector<int> large;					// indices into entries, of objects in no cell for their size
+	unordered_map<int, int> slots;		// id -> index in entries
+	AABB bounds;	// of everything put in cells so far; not shrunk on remove, rays are walked only inside it
+
+	explicit SpatialGrid(float aCellSize = 1) : cellSize(aCellSize) {}
+
+	void insert(int id, const AABB& box);
+	void remove(int id);
+	// cells in both old and new range are not touched
+	void move(int id, const AABB& box);
+	void clear();
+
+	int size() const {
+		return (int)entries.size();
+	}
+
+	// ids of objects with box overlapping box; sorted, unique
+	void queryBox(const AABB& box, vector<int>& ids) const;
+
+	// ids of objects with box not outside of frustum, by plane test as Frustum::classify; sorted, unique
+	void queryFrustum(const Frustum& f, vector<int>& ids) const;
+
+	// cells crossed by ray origin + t * dir, t >= 0, in order along it; visit(ids, tEnter, tExit) is called for every
+	// non empty one and returns false to stop. Object spanning several cells is in ids of the first of them only, so ids
+	// may be empty. Large objects come before any cell, in one visit with tEnter and tExit 0.
+	template <typename F> void walkRay(const Vec3F& origin, const Vec3F& dir, F visit) const {
+		if (!large.empty()) {
+			cellIds.clear();
+			for (int index : large) {
+				cellIds.push_back(entries[index].id);
+			}
+
+			if (!visit(cellIds, 0.0f, 0.0f)) {
+				return;
+			}
+		}
+
+		float o[3] = { origin.x, origin.y, origin.z };
+		float d[3] = { dir.x, dir.y, dir.z };
+		float lo[3] = { bounds.lo.x, bounds.lo.y, bounds.lo.z };
+		float hi[3] = { bounds.hi.x, bounds.hi.y, bounds.hi.z };
+
+		// clip to bounds
+		float tEnter = 0, tEnd = FLT_MAX;
+		for (int a = 0; a < 3; ++a) {
+			if (d[a] == 0) {
+				if (o[a] < lo[a] || o[a] > hi[a]) {
+					return;
+				}
+				continue;
+			}
+
+			float t1 = (lo[a] - o[a]) / d[a];
+			float t2 = (hi[a] - o[a]) / d[a];
+			tEnter = fmaxf(tEnter, fminf(t1, t2));
+			tEnd = fminf(tEnd, fmaxf(t1, t2));
+		}
+
+		if (entries.empty() || tEnter > tEnd) {
+			return;
+		}
+
+		nextMark();
+
+		CellRange limit = rangeOf(bounds);
+		int c[3], step[3];
+		float tNext[3], tDelta[3];
+		for (int a = 0; a < 3; ++a) {
+			float p = o[a] + d[a] * tEnter;
+			c[a] = max<int>(limit.lo[a], min<int>(limit.hi[a], cellOf(p)));
+
+			if (d[a] > 0) {
+				step[a] = 1;
+				tNext[a] = ((c[a] + 1) * cellSize - o[a]) / d[a];
+				tDelta[a] = cellSize / d[a];
+			}
+			else if (d[a] < 0) {
+				step[a] = -1;
+				tNext[a] = (c[a] * cellSize - o[a]) / d[a];
+				tDelta[a] = -cellSize / d[a];
+			}
+			else {
+				step[a] = 0;
+				tNext[a] = FLT_MAX;
+				tDelta[a] = FLT_MAX;
+			}
+		}
+
+		for (;;) {
+			int axis = tNext[0] < tNext[1] ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+			float tExit = fminf(tNext[axis], tEnd);
+
+			auto found = cells.find(key(c[0], c[1], c[2]));
+			if (found != cells.end()) {
+				cellIds.clear();
+				for (int index : found->second) {
+					if (marks[index] != mark) {
+						marks[index] = mark;
+						cellIds.push_back(entries[index].id);
+					}
+				}
+
+				if (!visit(cellIds, tEnter, tExit)) {
+					return;
+				}
+			}
+
+			c[axis] += step[axis];
+			if (tExit >= tEnd || c[axis] < limit.lo[axis] || c[axis] > limit.hi[axis]) {
+				return;
+			}
+
+			tEnter = tExit;
+			tNext[axis] += tDelta[axis];
+		}
+	}
+
+private:
+	mutable vector<int> cellIds;
+	vector<int> kept;
+	// entry was already looked at by query or walkRay with this mark; saves sorting out objects listed in several cells
+	mutable vector<unsigned int> marks;
+	mutable unsigned int mark = 0;
+
+	// new mark, no entry has it yet
+	void nextMark() const;
+
+	int cellOf(float v) const {
+		float c = floorf(v / cellSize);
+		if (!(c > -CELL_LIMIT)) {
+			return -CELL_LIMIT;
+		}
+		return c < CELL_LIMIT ? (int)c : CELL_LIMIT;
+	}
+
+	// 21 bits per axis, enough for +-1M cells
+	static long long key(int x, int y, int z) {
+		const long long mask = (1 << 21) - 1;
+		return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+	}
+
+	CellRange rangeOf(const AABB& box) const {
+		return {
+			{ cellOf(box.lo.x), cellOf(box.lo.y), cellOf(box.lo.z) },
+			{ cellOf(box.hi.x), cellOf(box.hi.y), cellOf(box.hi.z) }
+		};
+	}
+
+	// cells box is listed in; none for an empty or large box
+	CellRange cellsFor(const AABB& box) const;
+
+	// place of cell x, y, z in at of an entry listed in cells of r
+	static int cellIndex(const CellRange& r, int x, int y, int z) {
+		return ((x - r.lo[0]) * (r.hi[1] - r.lo[1] + 1) + (y - r.lo[1])) * (r.hi[2] - r.lo[2] + 1) + (z - r.lo[2]);
+	}
+
+	// list entry at index in every cell of its range, cells outside of keep only; at is filled for all of them
+	void addToCells(int index, const CellRange& keep);
+	// take entry at index out of one cell of its range
+	void removeFromCell(int index, int x, int y, int z);
+	void addToLarge(int index);
+	void removeFromLarge(int index);
+	// entry moved from index from to index to; its cells or large are told
+	void relabel(int from, int to);
+
+	// ids of objects with boxTest(box), looked for in cells of range r which pass cellTest(cell box); when range has more
+	// cells than it is worth looking up, all entries are tested instead. Sorted, unique
+	template <typename C, typename B> void query(const CellRange& r, C cellTest, B boxTest, vector<int>& ids) const;
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+// characters of Charmap128.png, row by row
+static constexpr char FONT_MAP[] = ""
+	"abcdefghijklm\n"
+	"nopqrstuvwxyz\n"
+	"ABCDEFGHIJKLM\n"
+	"NOPQRSTUVWXYZ\n"
+	"0123456789!@#\n"
+	"$%^&*()-=_+[]\n"
+	"{};':\",.<>|/\\?";
+
+// column and row of a character in the font texture, counted in characters
+struct GlyphCell {
+	unsigned char x;
+	unsigned char y;
+};
+
+struct GlyphTable {
+	GlyphCell cells[256];
+};
+
+// cell of every char value, first place it has in map; chars not in map get the last one, which should be ?
+constexpr GlyphTable makeGlyphTable(const char* map) {
+	GlyphTable t = {};
+	bool seen[256] = {};
+
+	int x = 0;
+	int y = 0;
+	for (int i = 0; map[i] != 0; ++i) {
+		unsigned char c = (unsigned char)map[i];
+		if (!seen[c]) {
+			seen[c] = true;
+			t.cells[c] = { (unsigned char)x, (unsigned char)y };
+		}
+
+		if (c == '\n') {
+			y += 1;
+			x = 0;
+		}
+		else {
+			x += 1;
+		}
+	}
+
+	for (int c = 0; c < 256; ++c) {
+		if (!seen[c]) {
+			t.cells[c] = { (unsigned char)(x - 1), (unsigned char)y };
+		}
+	}
+
+	return t;
+}
+
+constexpr GlyphTable FONT_GLYPHS = makeGlyphTable(FONT_MAP);
+
+// Where characters are in the font texture and how much space text takes; no GL, drawing is in TextPainterContext
+struct TextLayout {
+	// top left corner of a glyph in texture coordinates
+	struct GlyphUV {
+		float x;
+		float y;
+	};
+
+	const int TAB_SIZE = 8;
+	const int TEXTURE_SIZE = 128;
+
+	int fontCharHeight = 0;
+	int fontCharWidth = 0;
+
+	GlyphUV glyphs[256] = {};	// by unsigned char; filled by setCharSize
+	float glyphW = 0;			// size of a glyph in texture coordinates
+	float glyphH = 0;
+
+	void setCharSize(int width, int height) {
+		fontCharWidth = width;
+		fontCharHeight = height;
+
+		float tUnit = 1.0f / TEXTURE_SIZE;
+		glyphW = fontCharWidth * tUnit;
+		glyphH = fontCharHeight * tUnit;
+		for (int c = 0; c < 256; ++c) {
+			glyphs[c] = { FONT_GLYPHS.cells[c].x * glyphW, FONT_GLYPHS.cells[c].y * glyphH };
+		}
+	}
+
+	const GlyphUV& glyph(const char c) const {
+		return glyphs[(unsigned char)c];
+	}
+
+	void charCoord(const char c, int& x, int& y) const {
+		const GlyphCell& cell = FONT_GLYPHS.cells[(unsigned char)c];
+		x = cell.x;
+		y = cell.y;
+	}
+
+	void textSize(const string& text, int& width, int& height) {
+		textSizeChars(text, width, height);
+		width *= fontCharWidth;
+		height *= fontCharHeight;
+	}
+
+	void textSizeChars(const string& text, int& width, int& height) {
+		int lineMax = 0;
+		int x = 0;
+		int y = 1;
+		for (const char each: text) {
+			++x;
+			if (each == '\n') {
+				y++;
+				lineMax = max<int>(x, lineMax);
+			}
+		}
+
+		width = max<int>(x, lineMax);
+		height = y;
+	}
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <textlayout.h>
+#include <ui.h>
+
+using namespace std;
+
+// texture coordinates, color, then position; layout of GL_T2F_C3F_V3F, so a whole string is set up with one glInterleavedArrays
+struct TextVertex {
+	float s, t;
+	float r, g, b;
+	float x, y, z;
+};
+
+// string laid out into quads (4 vertices per glyph, top right, top left, bottom left, bottom right), drawn with one
+// call; remembers what it was laid out from, so it is rebuilt only when text, color or font metrics change
+struct TextMesh {
+	string text;
+	UIFillRGB color;
+	int charWidth = 0;
+	int charHeight = 0;
+
+	vector<TextVertex> vertices;
+	int used = 0;	// frame of TextMeshCache it was last asked for
+
+	bool matches(const TextLayout& layout, const UIFillRGB& aColor) const;
+
+	// tabs, newlines and spaces move the pen as TextLayout says; only visible glyphs get quads
+	void build(const TextLayout& layout, const string& aText, const UIFillRGB& aColor);
+
+	int size() const {
+		return (int)vertices.size();
+	}
+};
+
+// meshes of strings drawn lately, by text; same text in other colors is kept next to it. Meshes not asked for
+// during a frame are dropped at its end, so log lines which scrolled away do not pile up
+struct TextMeshCache {
+	unordered_map<string, vector<TextMesh>> meshes;
+	int frame = 0;
+
+	// no allocation when a mesh of this text and color is already there
+	const TextMesh& get(const TextLayout& layout, const string& text, const UIFillRGB& color);
+
+	void endFrame();
+
+	void clear() {
+		meshes.clear();
+	}
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+using namespace std;
+
+// Fixed set of worker threads, started once and kept for the whole run, so a parallel job costs a wake up instead of thread creation.
+// run() blocks; calling thread takes tasks too, so pool of size 1 has no workers and runs everything inline.
+struct ThreadPool {
+	explicit ThreadPool(int threads = defaultSize());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// calls task(i) for every i in [0, tasks), spread over all threads; returns when all are done
+	void run(int tasks, const function<void(int)>& task);
+
+	int size() const {
+		return (int)workers.size() + 1;
+	}
+
+	static int defaultSize();
+
+private:
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wake;
+	condition_variable done;
+
+	const function<void(int)>* job = nullptr;
+	int jobTasks = 0;
+	unsigned jobGeneration = 0;
+	atomic<int> nextTask;
+	int busyWorkers = 0;
+	bool stopping = false;
+
+	void work();
+	void takeTasks(const function<void(int)>& task, int tasks);
+};
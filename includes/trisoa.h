@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <geometry.h>
+#include <simd.h>
+
+using namespace std;
+
+enum SimdLevel {
+	SimdScalar,
+	SimdSSE,	// 4 triangles per step
+	SimdAVX2,	// 8 triangles per step
+};
+
+struct SoAHit {
+	int index;	// position in TriangleSoA
+	float t;
+	float u;
+	float v;
+};
+
+// Triangles unpacked into separate arrays (structure of arrays), with edges precomputed for Moller-Trumbore.
+// Arrays are padded with WIDTH degenerate triangles, so kernels can always load full vectors.
+struct TriangleSoA {
+	static const int WIDTH = 8;
+
+	vector<float> v0x, v0y, v0z;
+	vector<float> e1x, e1y, e1z;
+	vector<float> e2x, e2y, e2z;
+	vector<int> ids;
+	int count = 0;
+
+	void assign(const vector<Triangle>& tris);
+
+	// packs tris in given order; with BVH::order every leaf becomes a continuous range
+	void assign(const vector<Triangle>& tris, const vector<int>& order);
+
+	// overwrites one packed triangle, e.g. after its renderable moved
+	void set(int idx, const Triangle& t);
+
+	// tests triangles [first, first + length) against ray origin + t * dir, 0 < t < tMax; appends hits to out
+	void intersect(int first, int length, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out) const;
+
+private:
+	void resize(int n);
+};
+
+// plain pointers to the arrays of a TriangleSoA; kernels built with other instruction sets take these, so their
+// translation unit instantiates no STL code which the linker could pick over the baseline copy
+struct SoAArrays {
+	const float *v0x, *v0y, *v0z;
+	const float *e1x, *e1y, *e1z;
+	const float *e2x, *e2y, *e2z;
+
+	explicit SoAArrays(const TriangleSoA& soa);
+};
+
+typedef void (*SoAKernel)(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out);
+
+// best level supported by this cpu, checked once with cpuid
+SimdLevel detectSimd();
+const char* simdName(SimdLevel level);
+
+// kernel for given level, falls back to lower level if this build or cpu does not have it
+SoAKernel soaKernel(SimdLevel level);
+
+void intersectScalar(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out);
+#ifdef EXPLORER_X86
+void intersectSSE(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out);
+void intersectAVX2(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out);
+
+// tests [first, first + count) and writes hits into out, which has room for count hits; returns how many. Built with
+// AVX2 in trisoa_avx2.cxx, intersectAVX2 feeds it blocks and appends hits to the vector
+int intersectAVX2Block(const SoAArrays& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, SoAHit* out);
+#endif
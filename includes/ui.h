@@ -0,0 +1,169 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <log.h>
+#include <textlayout.h>
+
+using namespace std;
+
+struct OverlayBatch;
+
+// same value as SDL_BUTTON_LEFT, so UIEvent can carry SDL button numbers as they are
+const int UIButtonLeft = 1;
+
+inline float calculateCenter(float space, float box) {
+	return (space - box) / 2;
+}
+
+template <typename T> struct XYGeneric {
+	T x = 0;
+	T y = 0;
+};
+
+using XYFloat = XYGeneric<float>;
+
+struct UIEvent {
+
+	UIEvent(XYFloat aCursor, int aButton, bool aDown) : cursor(aCursor), button(aButton), down(aDown) {}
+
+	XYFloat cursor;
+	int button;
+	bool down;
+	bool captured = false;
+};
+
+struct UIRGB {
+	unsigned char r = 0;
+	unsigned char g = 0;
+	unsigned char b = 0;
+};
+
+struct UIFillRGB {
+	UIRGB top;
+	UIRGB bottom;
+};
+
+struct UIRGBConfig {
+	UIFillRGB textColor;
+	UIFillRGB background;
+	UIFillRGB border;
+};
+
+enum UIRectState {
+	UICursorIdle,
+	UICursorHover,
+	UICursorActive,
+};
+
+struct UITrigger {
+	virtual void onAction(int id) = 0;
+};
+
+struct UIRect {
+	XYFloat pos;
+	XYFloat textPos;
+	XYFloat size;
+
+	string text;
+	int id = -1;
+
+	UIRGBConfig* configHover;
+	UIRGBConfig* configActive;
+	UIRGBConfig* configIdle;
+
+	UITrigger* actionEvent = nullptr;
+	UIRGBConfig* currentState = nullptr;
+
+	UIRectState state = UICursorIdle;
+
+	void cursorAt(XYFloat &cursor) {
+		// active cursor is controlled by buttonAt
+		if (state == UICursorActive) {
+			return;
+		}
+
+		if (inRange(cursor)) {
+			updateState(UICursorHover);
+		}
+		else {
+			updateState(UICursorIdle);
+		}
+	}
+
+	void buttonAt(UIEvent &e) {
+		if (e.button != UIButtonLeft) {
+			return;
+		}
+		
+		if (inRange(e.cursor)) {
+			if (e.down && state != UICursorActive) {
+				updateState(UICursorActive);
+			}
+			else if (!e.down && state == UICursorActive) {
+				updateState(UICursorHover);
+				if (actionEvent) {
+					actionEvent->onAction(id);
+					e.captured = true;
+				}
+			}
+		}
+		else if (!e.down && state == UICursorActive) {
+			updateState(UICursorIdle);
+			e.captured = true;
+		}
+	}
+
+	bool inRange(XYFloat& cursor) const {
+		return pos.x <= cursor.x && pos.x + size.x > cursor.x && pos.y <= cursor.y && pos.y + size.y > cursor.y;
+	}
+
+	// background, border and label into overlay, with pos taken from origin; defined next to the renderer
+	void render(OverlayBatch& overlay, XYFloat origin) const;
+
+	void updateState(UIRectState newState) {
+		state = newState;
+		switch (state) {
+		case UICursorIdle: currentState = configIdle; return;
+		case UICursorActive: currentState = configActive; return;
+		case UICursorHover: currentState = configHover; return;
+		}
+	}
+
+	void centerText(TextLayout& layout) {
+		int textWidth;
+		int textHeight;
+		layout.textSize(text, textWidth, textHeight);
+
+		textPos.x = calculateCenter(size.x, textWidth);
+		textPos.y = calculateCenter(size.y, textHeight);
+	}
+};
+
+struct UIGroup {
+	vector<UIRect> parts;
+
+	void cursorAt(XYFloat cursor) {
+		XYFloat relativeCursor{ cursor.x - x, cursor.y - y };
+
+		for (UIRect &each : parts) {
+			each.cursorAt(relativeCursor);
+		}
+	}
+
+	void buttonAt(UIEvent &e) {
+		XYFloat relativeCursor{ e.cursor.x - x, e.cursor.y - y };
+		XYFloat origCursor = e.cursor;
+		e.cursor = relativeCursor;
+
+		for (UIRect& each : parts) {
+			each.buttonAt(e);
+		}
+
+		e.cursor = origCursor;
+	}
+
+	float x = 0;
+	float y = 0;
+
+	void render(OverlayBatch& overlay) const;
+};
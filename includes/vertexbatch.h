@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <trig.h>
+
+using namespace std;
+
+// color, then position; layout of GL_C3F_V3F, so a whole batch is set up with one glInterleavedArrays
+struct ColoredVertex {
+	float r, g, b;
+	float x, y, z;
+};
+
+// colored vertices collected for a single draw call; kept between frames, clear() does not give memory back
+struct VertexBatch {
+	vector<ColoredVertex> vertices;
+
+	void clear() {
+		vertices.clear();
+	}
+
+	int size() const {
+		return (int)vertices.size();
+	}
+
+	void add(const Vec3F& p, const Vec3F& color) {
+		vertices.push_back({ color.x, color.y, color.z, p.x, p.y, p.z });
+	}
+
+	void addLine(const Vec3F& a, const Vec3F& colorA, const Vec3F& b, const Vec3F& colorB) {
+		add(a, colorA);
+		add(b, colorB);
+	}
+
+	// 3 axis aligned lines of length 2*s crossing at p; lower end of each one has colorA, upper colorB
+	void addCross(const Vec3F& p, float s, const Vec3F& colorA, const Vec3F& colorB) {
+		addLine({ p.x - s, p.y, p.z }, colorA, { p.x + s, p.y, p.z }, colorB);
+		addLine({ p.x, p.y - s, p.z }, colorA, { p.x, p.y + s, p.z }, colorB);
+		addLine({ p.x, p.y, p.z - s }, colorA, { p.x, p.y, p.z + s }, colorB);
+	}
+
+	// lines 1 apart on plane at height y, from -half to half along x and along z
+	void addGrid(float y, int half, const Vec3F& color) {
+		float h = (float)half;
+		for (int x = -half; x <= half; ++x) {
+			addLine({ (float)x, y, -h }, color, { (float)x, y, h }, color);
+		}
+
+		for (int z = -half; z <= half; ++z) {
+			addLine({ -h, y, (float)z }, color, { h, y, (float)z }, color);
+		}
+	}
+};
@@ -1,38 +1,268 @@
 #include <log.h>
 #include <string>
+#include <cstring>
 #include <cstdarg>
-#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+MessageLog::MessageLog() : unreadMessages(0), minLevel(LogInfo), next(0) {
+	for (Slot& each : slots) {
+		each.stamp.store(0, memory_order_relaxed);
+		each.dropped.store(-1, memory_order_relaxed);
+		each.text[0] = 0;
+	}
+}
+
+MessageLog::~MessageLog() {
+	stopWriter();
+	flush();
+
+	if (spillFile) {
+		fclose(spillFile);
+	}
+}
 
 void MessageLog::printf(const char* format, ...) {
 	va_list args;
 	va_start(args, format);
-	vsprintf_s(buffer, format, args);
+	vprintfAt(LogInfo, format, args);
+	va_end(args);
+}
+
+void MessageLog::printfAt(LogLevel level, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	vprintfAt(level, format, args);
 	va_end(args);
+}
+
+void MessageLog::vprintfAt(LogLevel level, const char* format, va_list args) {
+	if (level < minLevel.load(memory_order_relaxed)) {
+		return;
+	}
+
+	// most messages fit on stack; longer ones are formatted again into a buffer of this thread, kept for next time
+	char buffer[512];
+	const char* text = buffer;
+
+	va_list again;
+	va_copy(again, args);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+
+	if (length >= (int)sizeof(buffer)) {
+		thread_local string longer;
+		longer.resize(length + 1);
+		vsnprintf(&longer[0], longer.size(), format, again);
+		text = longer.c_str();
+	}
+	va_end(again);
+
+	if (length < 0) {
+		return;
+	}
+
+	// empty lines between newlines are kept, empty rest after the last one is not
+	const char* start = text;
+	const char* end = text + length;
+	while (start < end) {
+		const char* newline = (const char*)memchr(start, '\n', end - start);
+		const char* lineEnd = newline ? newline : end;
+		addLine(start, lineEnd - start);
+		start = lineEnd + 1;
+	}
+}
+
+bool MessageLog::claimSlot(long long n) {
+	Slot& slot = slots[n % CAPACITY];
+
+	// only a published line older than n may be replaced; odd stamp is a writer still copying, newer one a writer
+	// which lapped this one before it got here
+	long long seen = slot.stamp.load(memory_order_relaxed);
+	while (seen % 2 == 0 && seen < 2 * n + 2) {
+		if (!slot.stamp.compare_exchange_weak(seen, 2 * n + 1)) {
+			continue;
+		}
+
+		// a later line dropped on this slot lets flush pass n as dropped too; old line is put back untouched
+		if (slot.dropped.load() < n) {
+			atomic_thread_fence(memory_order_release);
+			return true;
+		}
+		slot.stamp.store(seen);
+		break;
+	}
+
+	long long last = slot.dropped.load();
+	while (last < n && !slot.dropped.compare_exchange_weak(last, n)) {
+	}
+	return false;
+}
+
+void MessageLog::addLine(const char* text, size_t length) {
+	do {
+		size_t part = min<size_t>(length, LINE_SIZE - 1);
+
+		long long n = next.fetch_add(1, memory_order_relaxed);
+		Slot& slot = slots[n % CAPACITY];
+		if (claimSlot(n)) {
+#ifdef EXPLORER3D_TEST_HOOKS
+			if (claimedHook) {
+				claimedHook(n);
+			}
+#endif
+
+			memcpy(slot.text, text, part);
+			slot.text[part] = 0;
+
+			// slot is ours until this store; nobody else writes a stamp which is odd
+			slot.stamp.store(2 * n + 2, memory_order_release);
+
+			int unread = unreadMessages.fetch_add(1, memory_order_relaxed) + 1;
+			while (unread > MAX_UNREAD && !unreadMessages.compare_exchange_weak(unread, MAX_UNREAD, memory_order_relaxed)) {
+			}
+		}
+
+		// half of the ring filled since last wake up; writer should not wait for its interval
+		if ((n + 1) % (CAPACITY / 2) == 0) {
+			writerWake.notify_one();
+		}
+
+		text += part;
+		length -= part;
+	} while (length > 0);
+}
+
+bool MessageLog::readLine(long long n, string& out) const {
+	const Slot& slot = slots[n % CAPACITY];
+
+	long long published = 2 * n + 2;
+	if (slot.stamp.load(memory_order_acquire) != published) {
+		return false;
+	}
+
+	out.assign(slot.text, strnlen(slot.text, LINE_SIZE));
+
+	// writer may have started over this slot while it was copied
+	atomic_thread_fence(memory_order_acquire);
+	return slot.stamp.load(memory_order_relaxed) == published;
+}
+
+int MessageLog::last(int count, vector<string>& lines) const {
+	long long end = written();
+	int wanted = count < CAPACITY ? count : CAPACITY;
+	long long begin = max(end - wanted, 0LL);
+
+	if ((int)lines.size() < end - begin) {
+		lines.resize(end - begin);
+	}
+
+	int found = 0;
+	for (long long n = begin; n < end; ++n) {
+		if (readLine(n, lines[found])) {
+			++found;
+		}
+	}
+
+	return found;
+}
+
+bool MessageLog::spillTo(const char* path) {
+	lock_guard<mutex> guard(flushLock);
+	if (spillFile) {
+		fclose(spillFile);
+	}
+
+	spillFile = fopen(path, "w");
+	return spillFile != nullptr;
+}
+
+void MessageLog::flush() {
+	lock_guard<mutex> guard(flushLock);
+	if (!echo && !spillFile) {
+		flushed = written();
+		return;
+	}
 
-	std::cout << buffer;
+	long long end = written();
+	batch.clear();
 
-	char* start = buffer;
-	char* ptr = buffer;
+	// stops at a line still being written, it is taken next time; a writer stalled there keeps its slot, so its line
+	// is not lost however far others go. Lines dropped by writers are counted with overwritten ones
+	long long overwritten = 0;
+	for (; flushed < end; ++flushed) {
+		if (readLine(flushed, line)) {
+			if (overwritten > 0) {
+				batch += "[log] " + to_string(overwritten) + " lines overwritten before flush\n";
+				overwritten = 0;
+			}
 
-	for (;;) {
-		char here = *ptr;
-		if (here == '\n' || (here == 0 && ptr - start > 1)) {
-			*ptr = 0;
-			history.push_back(start);
-			++unreadMessages;
-			start = ptr + 1;
+			batch += line;
+			batch += '\n';
+			continue;
 		}
 
-		if (here == 0) {
-			break;
+		// this line is still coming, dropped, or gone with a newer one over it; dropped is read first, so a writer
+		// claiming the slot after that sees it and drops the line as well
+		const Slot& slot = slots[flushed % CAPACITY];
+		long long dropped = slot.dropped.load();
+		long long stamp = slot.stamp.load();
+		if (stamp > 2 * flushed + 2 || (stamp < 2 * flushed + 1 && dropped >= flushed)) {
+			++overwritten;
+			continue;
 		}
-		else {
-			++ptr;
+		break;
+	}
+
+	if (overwritten > 0) {
+		batch += "[log] " + to_string(overwritten) + " lines overwritten before flush\n";
+	}
+
+	if (batch.empty()) {
+		return;
+	}
+
+	if (echo) {
+		fwrite(batch.data(), 1, batch.size(), stdout);
+		fflush(stdout);
+	}
+
+	if (spillFile) {
+		fwrite(batch.data(), 1, batch.size(), spillFile);
+		fflush(spillFile);
+	}
+}
+
+void MessageLog::startWriter(int intervalMs) {
+	if (writer.joinable()) {
+		return;
+	}
+
+	writerStopping = false;
+	writer = thread([this, intervalMs]() {
+		unique_lock<mutex> lock(writerLock);
+		while (!writerStopping) {
+			writerWake.wait_for(lock, chrono::milliseconds(intervalMs));
+
+			lock.unlock();
+			flush();
+			lock.lock();
 		}
+	});
+}
+
+void MessageLog::stopWriter() {
+	if (!writer.joinable()) {
+		return;
 	}
 
-	unreadMessages = min(10, unreadMessages);
+	{
+		lock_guard<mutex> guard(writerLock);
+		writerStopping = true;
+	}
+	writerWake.notify_one();
+	writer.join();
 
+	flush();
 }
 
-MessageLog Log;
\ No newline at end of file
+MessageLog Log;
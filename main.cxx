@@ -8,6 +8,7 @@
 #include <list>
 #include <string>
 #include <cstdarg>
+#include <cstring>
 
 #include <Windows.h>
 #include <gl/gl.h>
@@ -18,52 +19,22 @@
 #include <log.h>
 #include <trig.h>
 #include <m44.h>
+#include <geometry.h>
+#include <hittest.h>
+#include <renderable.h>
+#include <scenemesh.h>
+#include <scenestore.h>
+#include <frustum.h>
+#include <textlayout.h>
+#include <textmesh.h>
+#include <overlaybatch.h>
+#include <cubeshape.h>
+#include <vertexbatch.h>
+#include <ui.h>
+#include <camera.h>
 
 using namespace std;
 
-template<typename T> int comp(const T& a, const T& b) {
-	return a < b;
-};
-
-float calculateCenter(float space, float box) {
-	return (space - box) / 2;
-}
-
-template <typename T> struct XYGeneric {
-	T x = 0;
-	T y = 0;
-};
-
-using XYFloat = XYGeneric<float>;
-
-struct UIEvent {
-
-	UIEvent(XYFloat aCursor, int aButton, bool aDown) : cursor(aCursor), button(aButton), down(aDown) {}
-
-	XYFloat cursor;
-	int button;
-	bool down;
-	bool captured = false;
-};
-
-struct UIRGB {
-	unsigned char r = 0;
-	unsigned char g = 0;
-	unsigned char b = 0;
-};
-
-struct UIFillRGB {
-	UIRGB top;
-	UIRGB bottom;
-};
-
-struct UIRGBConfig {
-	UIFillRGB textColor;
-	UIFillRGB background;
-	UIFillRGB border;
-};
-
-
 struct {
 	const UIFillRGB standardTextColor = { { 150, 150, 250 }, { 200, 200, 250 } };
 	const UIFillRGB darkerTextColor = { { 120, 120, 220 }, { 180, 180, 230 } };
@@ -116,6 +87,132 @@ struct OpenGLProperties {
 	}
 };
 
+// buffer objects from GL 1.5 or ARB_vertex_buffer_object; gl.h on Windows stops at 1.1, so entry points are looked up at runtime
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+struct {
+	typedef void (APIENTRY* GenBuffersProc)(GLsizei n, GLuint* buffers);
+	typedef void (APIENTRY* BindBufferProc)(GLenum target, GLuint buffer);
+	typedef void (APIENTRY* BufferDataProc)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+	typedef void (APIENTRY* BufferSubDataProc)(GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data);
+
+	GenBuffersProc genBuffers = nullptr;
+	BindBufferProc bindBuffer = nullptr;
+	BufferDataProc bufferData = nullptr;
+	BufferSubDataProc bufferSubData = nullptr;
+
+	// false means client arrays only
+	bool available = false;
+
+	void load(const OpenGLProperties& gl) {
+		char* end;
+		long major = strtol(gl.nameVersion.c_str(), &end, 10);
+		long minor = *end == '.' ? strtol(end + 1, nullptr, 10) : 0;
+
+		string suffix;
+		if (major > 1 || (major == 1 && minor >= 5)) {
+			suffix = "";
+		}
+		else if (SDL_GL_ExtensionSupported("GL_ARB_vertex_buffer_object")) {
+			suffix = "ARB";
+		}
+		else {
+			Log.printf("Vertex buffers: client arrays\n");
+			return;
+		}
+
+		genBuffers = (GenBuffersProc)SDL_GL_GetProcAddress(("glGenBuffers" + suffix).c_str());
+		bindBuffer = (BindBufferProc)SDL_GL_GetProcAddress(("glBindBuffer" + suffix).c_str());
+		bufferData = (BufferDataProc)SDL_GL_GetProcAddress(("glBufferData" + suffix).c_str());
+		bufferSubData = (BufferSubDataProc)SDL_GL_GetProcAddress(("glBufferSubData" + suffix).c_str());
+
+		available = genBuffers && bindBuffer && bufferData && bufferSubData;
+		Log.printf("Vertex buffers: %s\n", available ? (suffix.empty() ? "GL 1.5" : "ARB") : "client arrays");
+	}
+} GLBuffers;
+
+// array of interleaved vertices in a buffer object, or nothing when there are no buffer objects and arrays are used
+// straight from client memory
+struct ArrayBuffer {
+	GLenum usage;
+	GLuint name = 0;
+	size_t capacity = 0;	// bytes allocated in buffer object
+
+	ArrayBuffer(GLenum aUsage) : usage(aUsage) {}
+
+	// after array changed; reserved is how much to allocate when buffer has to grow. Streaming buffer is orphaned
+	// each time, so GL does not wait for draws of the previous frame
+	void upload(const void* data, size_t bytes, size_t reserved) {
+		if (!GLBuffers.available) {
+			return;
+		}
+
+		if (name == 0) {
+			GLBuffers.genBuffers(1, &name);
+		}
+
+		GLBuffers.bindBuffer(GL_ARRAY_BUFFER, name);
+		if (bytes > capacity || usage == GL_STREAM_DRAW) {
+			capacity = max<size_t>(capacity, reserved);
+			GLBuffers.bufferData(GL_ARRAY_BUFFER, capacity, nullptr, usage);
+		}
+
+		if (bytes > 0) {
+			GLBuffers.bufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+		}
+		GLBuffers.bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// glInterleavedArrays from buffer, or from data when there are no buffer objects; unbind() after drawing
+	void bindArrays(GLenum format, const void* data) const {
+		if (GLBuffers.available) {
+			GLBuffers.bindBuffer(GL_ARRAY_BUFFER, name);
+			glInterleavedArrays(format, 0, nullptr);
+		}
+		else {
+			glInterleavedArrays(format, 0, data);
+		}
+	}
+
+	// other client array pointers are plain memory
+	void unbind() const {
+		if (GLBuffers.available) {
+			GLBuffers.bindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+	}
+};
+
+// VertexBatch drawn from a buffer object, or straight from batch memory when there are no buffer objects
+struct VertexBuffer {
+	VertexBatch batch;
+	ArrayBuffer buffer;
+
+	VertexBuffer(GLenum aUsage) : buffer(aUsage) {}
+
+	void upload() {
+		const vector<ColoredVertex>& v = batch.vertices;
+		buffer.upload(v.data(), v.size() * sizeof(ColoredVertex), v.capacity() * sizeof(ColoredVertex));
+	}
+
+	// one glDrawArrays
+	void draw(GLenum mode, int first, int count) const {
+		if (count == 0) {
+			return;
+		}
+
+		buffer.bindArrays(GL_C3F_V3F, batch.vertices.data());
+		glDrawArrays(mode, first, count);
+		buffer.unbind();
+	}
+
+	void draw(GLenum mode) const {
+		draw(mode, 0, batch.size());
+	}
+};
 
 struct AppContext {
 	int windowWidth = 1200;
@@ -177,6 +274,7 @@ bool AppContext::startSDL() {
 
 	SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &openglProperties.major);
 	SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &openglProperties.minor);
+	GLBuffers.load(openglProperties);
 
 	cursorDefault = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_DEFAULT);
 	cursorPointer = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_POINTER);
@@ -198,128 +296,18 @@ enum MovementStrategy {
 	MoveXYZ,		// looking around with respect to top/bottom, moving on XZ plane, moving Up/Down only with dedicated commands
 };
 
-struct TextPainterContext {
-	const string FontMap = ""
-		"abcdefghijklm\n"
-		"nopqrstuvwxyz\n"
-		"ABCDEFGHIJKLM\n"
-		"NOPQRSTUVWXYZ\n"
-		"0123456789!@#\n"
-		"$%^&*()-=_+[]\n"
-		"{};':\",.<>|/\\?";
-
+struct TextPainterContext : public TextLayout {
 	GLuint fontTextName = 0;
-	int fontCharHeight = 0;
-	int fontCharWidth = 0;
-
-
-	void charCoord(const char c, int& x, int& y) {
-		// it just stops and state of x/y is taken as output
-		x = 0;
-		y = 0;
-		for (const char each : FontMap) {
-			if (each == c) {
-				return;
-			}
-			if (each == '\n') {
-				y += 1;
-				x = 0;
-			}
-			else {
-				x += 1;
-			}
-		}
+	TextMeshCache meshes;
 
-		// not found case: move to last character; which should be ?
-		--x;
+	// laid out once into TextMesh, then copied into overlay at x, y
+	void addString(OverlayBatch& overlay, const string& text, const UIFillRGB& color, float x, float y) {
+		overlay.addText(meshes.get(*this, text, color), x, y);
 	}
 
-	void textSize(const string& text, int& width, int& height) {
-		textSizeChars(text, width, height);
-		width *= fontCharWidth;
-		height *= fontCharHeight;
-	}
-
-	void textSizeChars(const string& text, int& width, int& height) {
-		int lineMax = 0;
-		int x = 0;
-		int y = 1;
-		for (const char each: text) {
-			++x;
-			if (each == '\n') {
-				y++;
-				lineMax = max<int>(x, lineMax);
-			}
-		}
-
-		width = max<int>(x, lineMax);
-		height = y;
-	}
-
-	void drawString(const string& text) {
+	void addString(OverlayBatch& overlay, const string& text, float x, float y) {
 		UIFillRGB color = { { 255,255,255 }, {180,180,180} };
-		drawStringColor(text, color);
-	}
-
-	const int TAB_SIZE = 8;
-	void drawStringColor(const string& text, const UIFillRGB& color) {
-		float oX = 0;
-		float oY = 0;
-
-		int cX = 0;
-		int cY = 0;
-
-		float tX = 0;
-		float tY = 0;
-
-		float tUnit = 1.0 / 128.0;
-		float tW = fontCharWidth * tUnit;
-		float tH = fontCharHeight * tUnit;
-
-		for (const char c : text) {
-			if (c == '\t') {
-				int xIdx = oX / fontCharWidth;
-				int tabbedIdx = (xIdx / TAB_SIZE + 1) * TAB_SIZE;
-				oX = tabbedIdx * fontCharWidth;
-
-			}
-			else if (c == '\n') {
-				oX = 0;
-				oY += fontCharHeight;
-			}
-			else if (c == ' ') {
-				oX += fontCharWidth;
-			}
-			else {
-				charCoord(c, cX, cY);
-				tX = cX * fontCharWidth * tUnit;
-				tY = cY * fontCharHeight * tUnit;
-
-				glBegin(GL_QUADS);
-
-				glColor3ub(color.top.r, color.top.g, color.top.b);
-				glColor3ub(color.top.r, color.top.g, color.top.b);
-				glTexCoord2f(tX + tW, tY);		glVertex2f(oX + fontCharWidth, oY);
-				glTexCoord2f(tX, tY);			glVertex2f(oX, oY);
-				glColor3ub(color.bottom.r, color.bottom.g, color.bottom.b);
-				glTexCoord2f(tX, tY + tH);		glVertex2f(oX, oY + fontCharHeight);
-				glTexCoord2f(tX + tW, tY + tH); glVertex2f(oX + fontCharWidth, oY + fontCharHeight);
-
-
-				glEnd();
-
-				oX += fontCharWidth;
-			}
-		}
-	}
-
-	void drawStringAt(string text, float x, float y) {
-		glPushMatrix();
-		glTranslatef(x, y, 0);
-
-		drawString(text);
-
-		glPopMatrix();
+		addString(overlay, text, color, x, y);
 	}
 
 	void bindTexture() {
@@ -329,178 +317,26 @@ struct TextPainterContext {
 
 } TextPainter;
 
-
-enum UIRectState {
-	UICursorIdle,
-	UICursorHover,
-	UICursorActive,
-};
-
-struct UITrigger {
-	virtual void onAction(int id) = 0;
-};
-
-struct UIRect {
-	XYFloat pos;
-	XYFloat textPos;
-	XYFloat size;
-
-	string text;
-	int id = -1;
-
-	UIRGBConfig* configHover;
-	UIRGBConfig* configActive;
-	UIRGBConfig* configIdle;
-
-	UITrigger* actionEvent = nullptr;
-	UIRGBConfig* currentState = nullptr;
-
-	UIRectState state = UICursorIdle;
-
-	void cursorAt(XYFloat &cursor) {
-		// active cursor is controlled by buttonAt
-		if (state == UICursorActive) {
-			return;
-		}
-
-		if (inRange(cursor)) {
-			updateState(UICursorHover);
-		}
-		else {
-			updateState(UICursorIdle);
-		}
-	}
-
-	void buttonAt(UIEvent &e) {
-		if (e.button != SDL_BUTTON_LEFT) {
-			return;
-		}
-		
-		if (inRange(e.cursor)) {
-			if (e.down && state != UICursorActive) {
-				updateState(UICursorActive);
-			}
-			else if (!e.down && state == UICursorActive) {
-				updateState(UICursorHover);
-				if (actionEvent) {
-					actionEvent->onAction(id);
-					e.captured = true;
-				}
-			}
-		}
-		else if (!e.down && state == UICursorActive) {
-			updateState(UICursorIdle);
-			e.captured = true;
-		}
-	}
-
-	bool inRange(XYFloat& cursor) const {
-		return pos.x <= cursor.x && pos.x + size.x > cursor.x && pos.y <= cursor.y && pos.y + size.y > cursor.y;
-	}
-
-	void drawBorder() const {
-		const UIFillRGB* c = &currentState->border;
-
-		glBegin(GL_LINE_LOOP);
-
-		glColor3ub(c->bottom.r, c->bottom.g, c->bottom.b);
-		glVertex3f(0, size.y, 0.0);
-		glVertex3f(size.x, size.y, 0.0);
-
-		glColor3ub(c->top.r, c->top.g, c->top.b);
-		glVertex3f(size.x, 0, 0.0);
-		glVertex3f(0, 0, 0.0);
-
-		glEnd();
-	}
-
-	void drawBackground() const {
-
-		const UIFillRGB* c = &currentState->background;
-
-		glBegin(GL_QUADS);
-
-		glColor3ub(c->bottom.r, c->bottom.g, c->bottom.b);
-		glVertex3f(0, size.y, 0.0);
-		glVertex3f(size.x, size.y, 0.0);
-
-		glColor3ub(c->top.r, c->top.g, c->top.b);
-		glVertex3f(size.x, 0, 0.0);
-		glVertex3f(0, 0, 0.0);
-
-		glEnd();
-	}
-
-	void updateState(UIRectState newState) {
-		state = newState;
-		switch (state) {
-		case UICursorIdle: currentState = configIdle; return;
-		case UICursorActive: currentState = configActive; return;
-		case UICursorHover: currentState = configHover; return;
-		}
+void UIRect::render(OverlayBatch& overlay, XYFloat origin) const {
+	if (!currentState) {
+		Log.printfAt(LogError, "[UI ERROR] id: %i has no state set, rendering aborted\n", id);
+		return;
 	}
+	float x = origin.x + pos.x;
+	float y = origin.y + pos.y;
 
-	void render() const {
-		if (!currentState) {
-			Log.printf("[UI ERROR] id: %i has no state set, rendering aborted\n", id);
-			return;
-		}
-		glTranslatef(pos.x, pos.y, 0);
-
-		glDisable(GL_TEXTURE_2D);
-		drawBackground();
-		drawBorder();
-		glEnable(GL_TEXTURE_2D);
-
-		glTranslatef(textPos.x, textPos.y, 0);
-		TextPainter.drawStringColor(text, currentState->textColor);
-	}
-
-	void centerText() {
-		int textWidth;
-		int textHeight;
-		TextPainter.textSize(text, textWidth, textHeight);
-
-		textPos.x = calculateCenter(size.x, textWidth);
-		textPos.y = calculateCenter(size.y, textHeight);
-	}
-};
-
-struct UIGroup {
-	vector<UIRect> parts;
-
-	void cursorAt(XYFloat cursor) {
-		XYFloat relativeCursor{ cursor.x - x, cursor.y - y };
-
-		for (UIRect &each : parts) {
-			each.cursorAt(relativeCursor);
-		}
-	}
-
-	void buttonAt(UIEvent &e) {
-		XYFloat relativeCursor{ e.cursor.x - x, e.cursor.y - y };
-		XYFloat origCursor = e.cursor;
-		e.cursor = relativeCursor;
-
-		for (UIRect& each : parts) {
-			each.buttonAt(e);
-		}
+	overlay.addQuad(x, y, size.x, size.y, currentState->background);
+	overlay.addFrame(x, y, size.x, size.y, currentState->border);
+	TextPainter.addString(overlay, text, currentState->textColor, x + textPos.x, y + textPos.y);
+}
 
-		e.cursor = origCursor;
+void UIGroup::render(OverlayBatch& overlay) const {
+	for (const UIRect &each : parts) {
+		each.render(overlay, { x, y });
 	}
+}
 
-	float x = 0;
-	float y = 0;
 
-	void render() const {
-		glTranslatef(x, y, 0);
-		for (const UIRect &each : parts) {
-			glPushMatrix();
-			each.render();
-			glPopMatrix();
-		}
-	}
-};
 
 enum MainUI_IDs {
 	SINGLEVIEW_ID = 100,
@@ -519,479 +355,38 @@ enum AllViews {
 	VIEW_ZY,
 };
 
-struct ClippingRange {
-	float left;
-	float right;
-	float bottom;
-	float top;
-};
-
-struct Camera {
-	static const float fovMax;
-	static const float fovMin;
-
-	float nearPlane = 0.1;
-	float farPlane = 100;
-	
-	bool perspective = true;
-	bool adjustOrtho = false;
-	float frustumRight = 0;
-	float frustumTop = 0;
-	GLdouble fov = 60;
-
-	Vec3F pos = { 0,0,0 };
-	Vec3F angle = { 0,0,0 };
-
-	XYFloat viewPos = { 0,0 };
-	XYFloat viewSize = { 0,0 };
-
-	ClippingRange orthoRange = { -1, 1, -1,1 };
-	float zoomFactor = 1;
-	
-	void applyCameraWheel(float dy) {
-		if (perspective) {
-			updateFov(fov -dy);
-		}
-		else if (adjustOrtho) {
-			zoomFactor -= 0.02 * dy;
-		}
-	}
-
-	void applyCameraDrag(float dx, float dy) {
-		if (perspective) {
-			return;
-		}
-
-		XYFloat unit = pixelRange();
-		Vec3F posDiff = { -dx * unit.x, -dy * unit.y, 0 };
-
-		posDiff = M44F().asRotateX(rad(angle.x)).ApplyOnPoint(posDiff);
-		posDiff = M44F().asRotateY(rad(angle.y)).ApplyOnPoint(posDiff);
-		posDiff = M44F().asRotateZ(rad(angle.z)).ApplyOnPoint(posDiff);
-
-		pos.add(posDiff);
-
-	}
+void Camera::applyViewport() {
+	glViewport(viewPos.x, viewPos.y, viewSize.x, viewSize.y);
+}
 
-	void updateFov(float newFov) {
-		fov = max<float>(min<float>(newFov, fovMax), fovMin);
-	}
+void Camera::applyProjection() {
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
 
-	XYFloat pixelRange() const {
-		ClippingRange r = calculateClippingRange();
-		return {
-			(r.right - r.left) / viewSize.x,
-			(r.bottom - r.top) / viewSize.y,
-		};
-	}
+	ClippingRange c = calculateClippingRange();
 
-	void applyViewport() {
-		glViewport(viewPos.x, viewPos.y, viewSize.x, viewSize.y);
+	if (perspective) {
+		glFrustum(c.left, c.right, c.bottom, c.top, nearPlane, farPlane);
+		frustumRight = c.right;
+		frustumTop = c.top;
 	}
-
-	ClippingRange calculateClippingRange() const {
-		if (!perspective && !adjustOrtho) {
-			return orthoRange;
-		}
-
-		ClippingRange c;
-		GLdouble aspectRatio;
-		aspectRatio = (1.0 * viewSize.x) / viewSize.y;
-
-		if (perspective) {
-			GLdouble tangent = tan(rad(fov / 2));
-
-			c.top = tangent * nearPlane;
-			c.right = c.top;
-			if (viewSize.x > viewSize.y) {
-				c.right *= aspectRatio;
-			}
-			else {
-				c.top /= aspectRatio;
-			}
-		}
-		else {
-			if (viewSize.x > viewSize.y) {
-				c.right = orthoRange.right;
-				c.top = orthoRange.top / aspectRatio;
-			}
-			else {
-				c.right = orthoRange.right * aspectRatio;
-				c.top = orthoRange.top;
-			}
-
-			c.right *= zoomFactor;
-			c.top *= zoomFactor;
-		}
-
-		c.left = -c.right;
-		c.bottom = -c.top;
-
-		return c;
-
+	else {
+		glOrtho(c.left, c.right, c.bottom, c.top, nearPlane, farPlane);
 	}
+}
 
-	void applyProjection() {
-		glMatrixMode(GL_PROJECTION);
-		glLoadIdentity();
-
-		ClippingRange c = calculateClippingRange();
-
-		if (perspective) {
-			glFrustum(c.left, c.right, c.bottom, c.top, nearPlane, farPlane);
-			frustumRight = c.right;
-			frustumTop = c.top;
-		}
-		else {
-			glOrtho(c.left, c.right, c.bottom, c.top, nearPlane, farPlane);
-		}
+void Camera::eyeCoords() const {
+	if (orientationMode == OrientationQuat) {
+		glMultMatrixf(orientation.conjugate().asM44().ptr());
 	}
-
-	void eyeCoords() const {
+	else {
 		glRotatef(-angle.z, 0, 0, 1);
 		glRotatef(-angle.x, 1, 0, 0);
 		glRotatef(-angle.y, 0, 1, 0);
-
-		glTranslatef(-pos.x, -pos.y, -pos.z);
-	}
-
-	void reset() {
-		pos = { 0,0,0 };
-		angle = { 0,0,0 };
-		fov = 0;
-	}
-
-	void displayCoords() const {
-		Log.printf("[ %.3f %.3f %.3f ], [%.3f %.3f %.3f]\n", pos.x, pos.y, pos.z, angle.x, angle.y, angle.z);
-	}
-};
-
-const float Camera::fovMax = 175;
-const float Camera::fovMin = 5;
-
-struct Line {
-	Vec3F first;
-	Vec3F second;
-};
-
-struct Triangle {
-	int id;
-	Vec3F vertices[3];
-
-	Vec3F normal() const {
-		Vec3F a = vertices[2];
-		Vec3F b = vertices[2];
-
-		a.sub(vertices[0]);
-		b.sub(vertices[1]);
-
-		return a.crossProduct(b);
-	}
-
-	void transform(M44F m) {
-		vertices[0] = m.ApplyOnPoint(vertices[0]);
-		vertices[1] = m.ApplyOnPoint(vertices[1]);
-		vertices[2] = m.ApplyOnPoint(vertices[2]);
-	}
-};
-
-
-
-struct HitPosition {
-	int id;
-	Vec3F v;
-
-	static int Ordered(const HitPosition& a, const HitPosition& b) {
-		// descending , as smaller Z = closer
-		return comp(b.v.z, a.v.z);
-	}
-};
-
-struct Quad {
-	int id;
-	array<Vec3F,4> vertices;
-
-	Quad(int aId, const float* aVertices, const unsigned int* faces) : id(aId), vertices({}) {
-		for (int i = 0; i < 4; ++i) {
-			int idx = faces[i]*3;
-			vertices[i] = {
-				aVertices[idx + 0],
-				aVertices[idx + 1],
-				aVertices[idx + 2]
-			};
-		}
-	}
-
-	pair<Triangle, Triangle> asTris() {
-		pair<Triangle, Triangle> p;
-		p.first = { id, {vertices[0], vertices[1], vertices[2]} };
-		p.second = { id, {vertices[2], vertices[3], vertices[0]} };
-		return p;
-	}
-};
-
-struct HitTest {
-	vector<Triangle> tris;
-	vector<HitPosition> hits;
-	Line line;
-
-	// return 1 if point is above line, -1 if is below, 0 if is on the line or outside of X axis
-	int overUnderLine(Vec3F& a, Vec3F& b) const{
-		// out of X axis
-		if (a.x < 0 && b.x < 0 || a.x > 0 && b.x > 0) {
-			return 0;
-		}
-
-		// both points are below (Y grows upwards) , so [0,0] is above
-		if (a.y < 0 && b.y < 0) {
-			return 1;
-		}
-
-		// both points are above, so [0,0] is below
-		if (a.y > 0 && b.y > 0) {
-			return -1;
-		}
-
-		// calculate f(0) for line between a and b
-		float lA = (b.y - a.y) / (b.x - a.x);
-		float lB = a.y - lA * a.x;
-
-		if (lB < 0) return 1;  // point [0,0] is above line hiting X
-		if (lB > 0) return -1;
-		return 0;
-	}
-
-	int pairIsOut(Vec3F& a, Vec3F& b) const {
-		if (a.x < 0 && b.x < 0 || a.x > 0 && b.x > 0) {
-			return 1;
-		}
-		else {
-			return 0;
-		}
-	}
-
-	// checks if point [0,0] is inside triangle a,b,c ignoring Z axis ; it will check it for infinite length of trace line, so requires distance check
-	bool hitTriangle(Triangle &t) const {
-		Vec3F& a = t.vertices[0];
-		Vec3F& b = t.vertices[1];
-		Vec3F& c = t.vertices[2];
-		int outOfX = pairIsOut(a,b) + pairIsOut(b,c) + pairIsOut(a,c);
-		if (outOfX == 3) { // it is either 0,1 or 3 for triangle
-			return false;
-		}
-		
-		int ab = overUnderLine(a, b);
-		int ac = overUnderLine(a, c);
-		int bc = overUnderLine(b, c);
-
-		int sum = ab + ac + bc;
-
-		// if is out then will reach -2 or 2 or in corner case of sharing X with vertex => -3 or 3
-		return sum >= -1 && sum <= 1;
-	}
-
-	// hit is calculated for point [0,0]; triangle is shifted in Z axis; calculate distance to triangle plain on Z axis
-	float zOffsetFromCenter(const Triangle& t) {
-		Vec3F n = t.normal();
-		// triangle plain equation is n.x*X + n.y*Y + n.z*Z + D = 0 ;
-		// to calculate D i pick first vertex from triangle, and then for Z it is n.x*0 + n.y*0 + n.z*Z + D = 0 => Z = -D/n.z
-
-		Vec3F v = t.vertices[0];
-		float D = -(n.x*v.x + n.y*v.y + n.z*v.z);
-
-		return -D / n.z;
-	}
-
-	bool check() {
-		Vec3F dir = line.second;
-		dir.sub(line.first);
-
-		Vec3F angles = dir.rotationYXZ(Vec3F::UP);
-
-		// Align all objects along 'line' so all calculations are along x,y axises
-		M44F m;
-		m.Mult(M44F().asRotateX(-angles.x))
-			.Mult(M44F().asRotateY(-angles.y))
-			.Mult(M44F().asTranslate(-line.first.x, -line.first.y, -line.first.z));
-
-		for (const Triangle& t : tris) {
-			Vec3F a = m.ApplyOnPoint(t.vertices[0]);
-			Vec3F b = m.ApplyOnPoint(t.vertices[1]);
-			Vec3F c = m.ApplyOnPoint(t.vertices[2]);
-			
-			Triangle mT = { t.id, {a,b,c} };
-
-			if (hitTriangle(mT)) {
-				float offsetZ = zOffsetFromCenter(mT);
-				
-				// distance > 0 means that triange is BEHIND (we look in direction [0,0,-1] axis)
-				if (offsetZ < 0) {
-					hits.push_back({ t.id, {0,0,offsetZ } });
-				}
-			}
-		}
-
-		if (hits.size() != 0) {
-			sort(hits.begin(), hits.end(), HitPosition::Ordered);
-
-			// figure out the strategy for multiple hits if triangle should hold it or ordered set of all handlers should decide if it passes or not
-
-			M44F revM;
-			revM.Mult(M44F().asTranslate(line.first.x, line.first.y, line.first.z))
-				.Mult(M44F().asRotateY(angles.y))
-				.Mult(M44F().asRotateX(angles.x));
-				
-
-			for (HitPosition& t : hits) {
-				t.v = revM.ApplyOnPoint(t.v);
-			}
-
-			return true;
-		}
-		else {
-			return false;
-		}
-		
-	}
-};
-
-struct Renderable {
-	virtual int getId() const = 0;
-	virtual void mesh(vector<Triangle>& fill) const = 0;
-	virtual void render(int frames) const = 0;
-	virtual void toggleSelect() = 0;
-};
-
-struct ModelCube : public Renderable {
-	
-	int id = 0;
-
-	int getId() const{
-		return id;
-	}
-
-	void toggleSelect() {
-		wireframe = !wireframe;
-	}
-
-	bool wireframe = false;
-	Vec3F pos = { 0,0,0 };
-	Vec3F angle = { 0,0,0 };
-	Vec3F scale = { 1,1,1 };
-
-	array<GLuint,24> facesIndices = {
-			0,1,2,3, // -z
-			4,5,6,7, // +z
-
-			0,1,5,4, // -x
-			2,3,7,6, // +x
-
-			1,2,6,5, // -y
-			0,3,7,4, // +y
-	};
-
-	array<GLfloat, 24> vertices = {
-			-1, 1,-1,
-			-1,-1,-1,
-			 1,-1,-1,
-			 1, 1,-1,
-
-			-1, 1, 1,
-			-1,-1, 1,
-			 1,-1, 1,
-			 1, 1, 1,
-	};
-
-	array<GLfloat, 24> colors = {
-			1.0, 0.0, 0.0,
-			0.0, 0.1, 0.0,
-			0.0, 0.0, 1.0,
-			1.0, 1.0, 0.0,
-
-			0.0, 1.0, 1.0,
-			1.0, 0.0, 1.0,
-			1.0, 1.0, 1.0,
-			0.3, 0.3, 0.3,
-	};
-
-	void mesh(vector<Triangle> &fill) const {
-		M44F m;
-		m.asTranslate(pos.x, pos.y, pos.z)
-			.Mult(M44F().asRotateZ(rad(angle.z)))
-			.Mult(M44F().asRotateX(rad(angle.x)))
-			.Mult(M44F().asRotateY(rad(angle.y)))
-			.Mult(M44F().asScale(scale.x, scale.y, scale.z));
-
-
-		for (int i = 0; i < 6; ++i) {
-			Quad q(id, vertices.data(), facesIndices.data()+(i*4));
-
-			pair<Triangle, Triangle> tris = q.asTris();
-
-			tris.first.transform(m);
-			tris.second.transform(m);
-
-			fill.push_back(tris.first);
-			fill.push_back(tris.second);
-		}
 	}
 
-	void render(int frames) const {
-		// first approach - fixed cube rendering
-		glPushMatrix();
-		
-		bool glMatrix = false;
-		if (glMatrix) {
-			glTranslatef(pos.x, pos.y, pos.z);
-
-			glRotatef(angle.z, 0, 0, 1);
-			glRotatef(angle.x, 1, 0, 0);
-			glRotatef(angle.y, 0, 1, 0);
-
-			glScalef(scale.x, scale.y, scale.z);
-		}
-		else {
-			M44F m;
-			m.asTranslate(pos.x, pos.y, pos.z)
-				.Mult(M44F().asRotateZ(rad(angle.z)))
-				.Mult(M44F().asRotateX(rad(angle.x)))
-				.Mult(M44F().asRotateY(rad(angle.y)))
-				.Mult(M44F().asScale(scale.x, scale.y, scale.z));
-
-			glMultMatrixf(m.ptr());
-		}
-
-		
-		glColorPointer(3, GL_FLOAT, 0, colors.data());
-		glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-
-		glDrawElements(GL_QUADS, 6 * 4, GL_UNSIGNED_INT, facesIndices.data());
-		glPolygonOffset(0, 0.2);
-		if (wireframe) {
-			glLineWidth(2);
-			int quad = 0;
-			int vidx = 0;
-			for (GLuint i : facesIndices) {
-				vidx = i * 3;
-				//glColor3fv(&colors[vidx]);
-				glColor3f(1,1,1);
-				if (quad % 4 == 0) {
-					if (quad != 0) {
-						glEnd();
-					}
-					glBegin(GL_LINE_LOOP);
-				}
-				++quad;
-				glVertex3fv(&vertices[vidx]);
-			}
-			glEnd();
-			glLineWidth(1);
-		}
-		
-		glPolygonOffset(0, 0);
-		glPopMatrix();
-	}
-};
+	glTranslatef(-pos.x, -pos.y, -pos.z);
+}
 
 struct DrawPlane : UITrigger {
 	Camera camera;
@@ -1011,7 +406,29 @@ struct DrawPlane : UITrigger {
 
 	list<Line> lines;
 	list<Vec3F> markers;
-	vector<shared_ptr<Renderable>> renderables;
+
+	// grids, spinning quad and axes of renderAngles; built once
+	VertexBuffer staticGeometry = { GL_STATIC_DRAW };
+	int gridsCount = 0;
+	int quadFirst = 0;
+	int axesFirst = 0;
+
+	// trace lines and markers, rebuilt once per frame and drawn by every view
+	VertexBuffer frameLines = { GL_STREAM_DRAW };
+
+	// cubes in view of camera being rendered, pre-transformed; unbatched renderables are drawn one by one
+	CubeBatch cubeBatch;
+	vector<const Renderable*> unbatched;
+	vector<int> visibleIds;
+
+	// cubes as component arrays, other objects as Renderable
+	SceneStore scene;
+
+	// world space triangles of scene, used for area selection; re-meshed only for objects which changed
+	SceneMesh sceneMesh;
+	HitTest cursorHitTest;
+	PacketHitTest areaHitTest;
+	vector<int> areaIds;
 
 	MovementStrategy movement = MoveHybrid;
 	const int fovDiff = 1;
@@ -1027,30 +444,30 @@ struct DrawPlane : UITrigger {
 
 	UIGroup mainUI;
 
+	// 2D overlay of a frame: buttons, messages and counters, streamed to GL once per frame
+	OverlayBatch overlay;
+	ArrayBuffer overlayBuffer = { GL_STREAM_DRAW };
+
 	const int framesForMessage = 120;
 	int endOfMessageFrame = 0;
+	vector<string> messageLines;	// newest lines of Log, kept between frames
 
 	bool multiViewEnabled = false;
 
 	XYFloat dragXY;
 	bool dragging = false;
-	
-	int nextId = 1;
-	int reserveId(int count) {
-		int r = nextId;
-		nextId += count;
 
-		return r;
-	}
+	// left button let go this far from where it went down selects a rectangle instead of clicking
+	XYFloat selectFromXY;
+	bool selecting = false;
+	const float selectMinDrag = 4;
+	const float selectRayStep = 4;	// pixels between rays of a rectangle selection
 
-	Renderable* renderableForId(int id) {
-		for (const shared_ptr<Renderable>& each : renderables) {
-			if (id == each->getId()) {
-				return each.get();
-			}
+	// object under cursor goes away; cursor is updated on next pointer move
+	void removePointed() {
+		if (cursorId != -1 && scene.remove(cursorId)) {
+			cursorId = -1;
 		}
-
-		return nullptr;
 	}
 
 	void showMessages() {
@@ -1059,16 +476,11 @@ struct DrawPlane : UITrigger {
 			endOfMessageFrame = framesForMessage;
 		}
 		
-		auto ptr = Log.history.cend();
-		for (int i = Log.unreadMessages - 1; i >= 0; --i) {
-			--ptr;
-
-			glPushMatrix();
-			glTranslatef(0, i * TextPainter.fontCharHeight + 2, 0);
-			TextPainter.drawString(*ptr);
-			glPopMatrix();
+		// oldest on top
+		int shown = Log.last(Log.unreadMessages, messageLines);
+		for (int i = 0; i < shown; ++i) {
+			TextPainter.addString(overlay, messageLines[i], 0, i * TextPainter.fontCharHeight + 2);
 		}
-		
 
 		endOfMessageFrame -= 1;
 		if (endOfMessageFrame == 0) {
@@ -1201,8 +613,7 @@ struct DrawPlane : UITrigger {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 128, 128, 0, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
 		SDL_DestroySurface(surface);
 
-		TextPainter.fontCharHeight = 18;
-		TextPainter.fontCharWidth = 9;
+		TextPainter.setCharSize(9, 18);
 	}
 
 	void setupConsoleView() {
@@ -1237,16 +648,17 @@ struct DrawPlane : UITrigger {
 		int FLOODCOUNT = 10;
 		for (int x = -FLOODCOUNT; x < FLOODCOUNT; ++x)
 		for (int z = -FLOODCOUNT; z < FLOODCOUNT; ++z) {
-			ModelCube r;
+			CubeShape r;
 			r.pos = { (float)(x * 0.5), 5 ,(float)(z * 0.5) };
 			r.angle = { 45,45,45 };
 			r.scale = { 0.2,0.2,0.2 };
 
-			renderables.push_back(make_shared<ModelCube>(r));
+			scene.addCube(r);
 		}
 	}
 
 	void init() {
+		buildStaticGeometry();
 		loadFontTexture();
 		setupConsoleView();
 		setupXYZCameras();
@@ -1305,7 +717,7 @@ struct DrawPlane : UITrigger {
 
 			button.text = name;
 			button.size = { 150, 30 };
-			button.centerText();
+			button.centerText(TextPainter);
 			button.id = id;
 			button.actionEvent = this;
 
@@ -1344,12 +756,33 @@ struct DrawPlane : UITrigger {
 		SDL_SetCursor(App.cursorPointer);
 	}
 
+	// only objects in grid cells along the line are meshed and tested
 	bool hitTestOnRenderables(HitTest& ht) {
-		for (const shared_ptr<Renderable>& each : renderables) {
-			each->mesh(ht.tris);
-		}
+		scene.syncBounds();
+		return ht.check(scene.grid, [&](int id, vector<Triangle>& tris) {
+			scene.meshObject(id, tris);
+		});
+	}
 
-		return ht.check();
+	// ids of renderables visible in screen rectangle a-b of camera c; one ray every step pixels, so objects smaller than that may be missed
+	const vector<int>& renderablesInRect(const Camera& c, XYFloat a, XYFloat b, float step) {
+		PacketHitTest& pt = areaHitTest;
+		c.linesInRect(a, b, step, App.windowHeight, pt.rays);
+
+		sceneMesh.update(scene);
+		pt.check(sceneMesh.soa, sceneMesh.bvh);
+		return pt.ids;
+	}
+
+	// selection of every object in rectangle a-b of camera c is toggled, as a click does for one; visible ones only,
+	// or with shift held those hidden behind others too
+	void selectInRect(const Camera& c, XYFloat a, XYFloat b) {
+		bool hiddenToo = (SDL_GetModState() & SDL_KMOD_SHIFT) != 0;
+		const vector<int>& ids = hiddenToo ? renderablesInFrustum(c, a, b) : renderablesInRect(c, a, b, selectRayStep);
+
+		for (int id : ids) {
+			scene.toggleSelect(id);
+		}
 	}
 
 	void onRunHittest() {
@@ -1370,11 +803,10 @@ struct DrawPlane : UITrigger {
 		lines.pop_front();
 	}
 
-	ModelCube modelCubeAt(const Camera& c, const XYFloat& xy) {
+	CubeShape modelCubeAt(const Camera& c, const XYFloat& xy) {
 		Line l = traceLineRanged(c, xy, 2);
-		ModelCube r;
+		CubeShape r;
 
-		r.id = reserveId(1);
 		r.pos = l.second;
 		r.angle = { 45,45,45 };
 		r.scale = { 0.2,0.2,0.2 };
@@ -1383,53 +815,20 @@ struct DrawPlane : UITrigger {
 	}
 
 	Line traceLineRanged(const Camera& c, const XYFloat& xy, float range) {
-		M44F m;
-		m
-			.Mult(M44F().asTranslate(c.pos.x, c.pos.y, c.pos.z))
-			.Mult(M44F().asRotateY(rad(c.angle.y)))
-			.Mult(M44F().asRotateX(rad(c.angle.x)))
-			.Mult(M44F().asRotateZ(rad(c.angle.z)));
-
-		// align xy to camera top left corner
-		int updatedY = xy.y - (App.windowHeight - c.viewPos.y - c.viewSize.y);
-		int updatedX = xy.x - c.viewPos.x;
-
-		float pRight = 0;
-		float pTop = 0;
-
-		Vec3F lineStart = { 0,0,0 };
-		Vec3F lineEnd = { 0,0,0 };
-		if (c.perspective) {
-			float xRatio = updatedX / c.viewSize.x * 2 - 1;
-			float yRatio = updatedY / c.viewSize.y * 2 - 1;
-
-			pRight = xRatio * c.frustumRight; // minus xRatio because we rotate along Y axis
-			pTop = -yRatio * c.frustumTop;
-
-			lineEnd = { pRight,pTop,-c.nearPlane };
-			lineEnd.normalize().mult(range);
-		}
-		else {
-			float xRatio = updatedX / c.viewSize.x;
-			float yRatio = updatedY / c.viewSize.y;
-
-			ClippingRange r = c.calculateClippingRange();
-
-			pRight = r.left + (r.right - r.left) * xRatio;
-			pTop = r.top - (r.top - r.bottom) * yRatio;
-
-			lineStart = { pRight, pTop, 100 };
-			lineEnd = { pRight, pTop, -range };
-		}
-
-
-		return { m.ApplyOnPoint(lineStart) , m.ApplyOnPoint(lineEnd) };
+		return c.lineAt(xy, App.windowHeight, range);
 	}
 
 	Line traceLine(const Camera& c, const XYFloat& xy) {
 		return traceLineRanged(c, xy, c.farPlane);
 	}
 
+	// ids of renderables with any triangle inside screen rectangle a-b of camera c, hidden ones included
+	const vector<int>& renderablesInFrustum(const Camera& c, XYFloat a, XYFloat b) {
+		sceneMesh.update(scene);
+		c.frustumInRect(a, b, App.windowHeight).collectIds(sceneMesh.bvh, sceneMesh.tris, areaIds);
+		return areaIds;
+	}
+
 	void applyMovesXYZ(Camera &c) {
 		Vec3F vRotated = { 0,0,0 };
 		Vec3F v = { moveAlongX * moveSpeed, 0, moveAlongZ * moveSpeed };
@@ -1449,19 +848,18 @@ struct DrawPlane : UITrigger {
 		Vec3F vRotated = { 0,0,0 };
 		Vec3F v = { moveAlongX * moveSpeed, moveAlongY * moveSpeed, moveAlongZ * moveSpeed };
 
-		M44F m; 
-		m
-			.Mult(M44F().asRotateY(rad(c.angle.y)))
-			.Mult(M44F().asRotateX(rad(c.angle.x)))
-			.Mult(M44F().asRotateZ(rad(c.angle.z)));
-
-		vRotated = m.ApplyOnPoint(v);
+		vRotated = c.rotation().ApplyOnPoint(v);
 		c.pos.add(vRotated);
 	}
 
 	void applyMoves(Camera &c) {
 		if (rotateZ) {
-			c.angle.z += 0.8 * rotateZ;
+			if (c.orientationMode == OrientationQuat) {
+				c.orientation.Mult(Quat::rotateZ(rad(0.8 * rotateZ))).normalize();
+			}
+			else {
+				c.angle.z += 0.8 * rotateZ;
+			}
 		}
 
 		if (moveAlongX == 0 && moveAlongZ == 0 && moveAlongY == 0) {
@@ -1485,33 +883,16 @@ struct DrawPlane : UITrigger {
 		if (c.angle.x > 90) c.angle.x = 90;
 	}
 
+	// turn around eye's own Y then X axis; composed on quaternion, angles are not touched
 	void pointerUpdateFreespace(Camera &c, float dX, float dY) {
 		float oY = App.pointerSpeed * -dX;
 		float oX = App.pointerSpeed * -dY;
 
-		M44F m;
-		m.Mult(M44F().asRotateY(rad(c.angle.y)))
-			.Mult(M44F().asRotateX(rad(c.angle.x)))
-			.Mult(M44F().asRotateZ(rad(c.angle.z)))
-			.Mult(M44F().asRotateY(rad(oY)))
-			.Mult(M44F().asRotateX(rad(oX)));
-		
-
-		Vec3F fwd = { 0,0,-1 };
-		Vec3F up = { 0,1,0 };
-
-		Vec3F nFwd = m.ApplyOnPoint(fwd);
-		Vec3F nUp = m.ApplyOnPoint(up);
-
-		vectorsToAngles(c, nFwd, nUp);
-	}
-
-	void vectorsToAngles(Camera &c, Vec3F& fwd, Vec3F& up) {
-		Vec3F rotationVector = fwd.rotationYXZ(up);
-		
-		c.angle.x = deg(rotationVector.x);
-		c.angle.y = deg(rotationVector.y);
-		c.angle.z = deg(rotationVector.z);
+		c.setOrientationMode(OrientationQuat);
+		c.orientation
+			.Mult(Quat::rotateY(rad(oY)))
+			.Mult(Quat::rotateX(rad(oX)))
+			.normalize();
 	}
 
 	void pointerUpdate(Camera &c, float dX, float dY) {
@@ -1531,7 +912,9 @@ struct DrawPlane : UITrigger {
 
 		cursorLine = traceLine(cameraAtXY(xy), xy);
 		
-		HitTest ht;
+		// kept between events, so hits vector keeps its capacity; only the nearest hit is needed here
+		HitTest& ht = cursorHitTest;
+		ht.query = HitClosest;
 		ht.line = cursorLine;
 
 		if (hitTestOnRenderables(ht)) {
@@ -1567,7 +950,7 @@ struct DrawPlane : UITrigger {
 			dragXY = xy;
 
 			SDL_SetCursor(dragging ? App.cursorPointer : App.cursorDefault);
-			Log.printf("Dragging %i at {%f,%f}\n", dragging, dragXY.x, dragXY.y);
+			LOG_DEBUG("Dragging %i at {%f,%f}\n", dragging, dragXY.x, dragXY.y);
 		}
 	}
 
@@ -1585,15 +968,23 @@ struct DrawPlane : UITrigger {
 			//lines.push_back(traceLine(c, e.cursor));
 		}
 
+		if (e.down && idx == SDL_BUTTON_LEFT && !e.captured) {
+			selectFromXY = xy;
+			selecting = true;
+		}
+
 		if (!e.down && idx == SDL_BUTTON_LEFT && !e.captured) {
-			if (cursorId == -1) {
-				renderables.push_back(make_shared<ModelCube>(modelCubeAt(c, e.cursor)));
+			bool rect = selecting && (fabsf(xy.x - selectFromXY.x) > selectMinDrag || fabsf(xy.y - selectFromXY.y) > selectMinDrag);
+			selecting = false;
+
+			if (rect) {
+				selectInRect(cameraAtXY(selectFromXY), selectFromXY, xy);
+			}
+			else if (cursorId == -1) {
+				scene.addCube(modelCubeAt(c, e.cursor));
 			}
 			else {
-				Renderable* pointed = renderableForId(cursorId);
-				if (pointed) {
-					pointed->toggleSelect();
-				}
+				scene.toggleSelect(cursorId);
 			}
 		}
 	}
@@ -1623,7 +1014,7 @@ struct DrawPlane : UITrigger {
 				glEnd();
 			}
 			GLenum err = glGetError();
-			if (err) { Log.printf("[ ERROR ] %i\n", err); }
+			if (err) { Log.printfAt(LogError, "[ ERROR ] %i\n", err); }
 
 			glDisable(GL_BLEND);
 			glDisable(GL_TEXTURE_2D);
@@ -1634,6 +1025,8 @@ struct DrawPlane : UITrigger {
 	void renderAngles(Camera& anglesOf) {
 		cameraAngles.viewPos = anglesOf.viewPos;
 		cameraAngles.angle = anglesOf.angle;
+		cameraAngles.orientationMode = anglesOf.orientationMode;
+		cameraAngles.orientation = anglesOf.orientation;
 		cameraAngles.applyViewport();
 		cameraAngles.applyProjection();
 
@@ -1642,69 +1035,83 @@ struct DrawPlane : UITrigger {
 
 		cameraAngles.eyeCoords();
 
-		glBegin(GL_LINES);
-		glColor4f(1, 0, 0, 1);
-		glVertex3f(0, 0, 0);
-		glVertex3f(1, 0, 0);
+		staticGeometry.draw(GL_LINES, axesFirst, 6);
+	}
+
+	void buildStaticGeometry() {
+		VertexBatch& b = staticGeometry.batch;
+		b.addGrid(0, 10, { 0.3, 0.3, 0.3 });
+		b.addGrid(3, 10, { 0.3, 0.3, 0.5 });
+		gridsCount = b.size();
 
-		glColor4f(0, 1, 0, 1);
-		glVertex3f(0, 0, 0);
-		glVertex3f(0, 1, 0);
+		quadFirst = b.size();
+		b.add({ -1,-1,0 }, { 1,1,0 });
+		b.add({ 1,-1,0 }, { 1,0,1 });
+		b.add({ 1,1,0 }, { 0,1,1 });
+		b.add({ -1,1,0 }, { 1,1,1 });
 
-		glColor4f(0, 0, 1, 1);
-		glVertex3f(0, 0, 0);
-		glVertex3f(0, 0, 1);
-		glEnd();
+		axesFirst = b.size();
+		b.addLine({ 0,0,0 }, { 1,0,0 }, { 1,0,0 }, { 1,0,0 });
+		b.addLine({ 0,0,0 }, { 0,1,0 }, { 0,1,0 }, { 0,1,0 });
+		b.addLine({ 0,0,0 }, { 0,0,1 }, { 0,0,1 }, { 0,0,1 });
 
+		staticGeometry.upload();
 	}
 
-	void renderTraceLines() {
-		glBegin(GL_LINES);
+	// trace lines, hit markers and cursor marker, in one streaming buffer for all views of this frame
+	void buildFrameLines() {
+		VertexBatch& b = frameLines.batch;
+		b.clear();
+
 		for (const Line& p : lines) {
-			glColor3f(0, 1, 1); glVertex3f(p.first.x, p.first.y, p.first.z);
-			glColor3f(1, 1, 0); glVertex3f(p.second.x, p.second.y, p.second.z);
+			b.addLine(p.first, { 0,1,1 }, p.second, { 1,1,0 });
 		}
-		glEnd();
-	}
 
-	void renderMarkers() {
-		glBegin(GL_LINES);
 		float s = 0.1;
 		for (const Vec3F& p : markers) {
-			glColor3f(1, 1, 1); glVertex3f(p.x-s, p.y, p.z);
-			glColor3f(1, 1, 1); glVertex3f(p.x+s, p.y, p.z);
-
-			glColor3f(1, 1, 1); glVertex3f(p.x, p.y-s, p.z);
-			glColor3f(1, 1, 1); glVertex3f(p.x, p.y+s, p.z);
-
-			glColor3f(1, 1, 1); glVertex3f(p.x, p.y, p.z-s);
-			glColor3f(1, 1, 1); glVertex3f(p.x, p.y, p.z+s);
+			b.addCross(p, s, { 1,1,1 }, { 1,1,1 });
 		}
-		glEnd();
-	}
 
-	void renderCursorMarker() {
-		glBegin(GL_LINES);
-		float s = 0.1;
+		if (cursorId != -1) {
+			b.addCross(cursorMarker, s, { 1,0,1 }, { 1,1,1 });
+		}
 
-		Vec3F& p = cursorMarker;
+		frameLines.upload();
+	}
 
-		glColor3f(1, 0, 1); glVertex3f(p.x - s, p.y, p.z);
-		glColor3f(1, 1, 1); glVertex3f(p.x + s, p.y, p.z);
+	// only objects with boxes in view of c, as grid finds them; the rest is counted as culled
+	void buildCubeBatch(Camera& c) {
+		cubeBatch.clear();
+		unbatched.clear();
 
-		glColor3f(1, 0, 1); glVertex3f(p.x, p.y - s, p.z);
-		glColor3f(1, 1, 1); glVertex3f(p.x, p.y + s, p.z);
+		scene.syncBounds();
+		scene.grid.queryFrustum(c.viewFrustum(), visibleIds);
+		scene.batch(cubeBatch, unbatched, visibleIds);
 
-		glColor3f(1, 0, 1); glVertex3f(p.x, p.y, p.z - s);
-		glColor3f(1, 1, 1); glVertex3f(p.x, p.y, p.z + s);
-		
-		glEnd();
+		c.stats.visible = (int)visibleIds.size();
+		c.stats.culled = scene.objectCount() - c.stats.visible;
 	}
 
 	void renderRenderables() const{
 		glEnableClientState(GL_VERTEX_ARRAY);
 		glEnableClientState(GL_COLOR_ARRAY);
-		for (const shared_ptr<Renderable>& each : renderables) {
+
+		if (cubeBatch.cubes > 0) {
+			glVertexPointer(3, GL_FLOAT, 0, cubeBatch.positions.data());
+			glColorPointer(3, GL_FLOAT, 0, cubeBatch.colors.data());
+			glDrawElements(GL_QUADS, cubeBatch.faceIndexCount(), GL_UNSIGNED_INT, cubeBatch.faces.data());
+
+			if (!cubeBatch.edges.empty()) {
+				glLineWidth(2);
+				glDisableClientState(GL_COLOR_ARRAY);
+				glColor3f(1, 1, 1);
+				glDrawElements(GL_LINES, (GLsizei)cubeBatch.edges.size(), GL_UNSIGNED_INT, cubeBatch.edges.data());
+				glEnableClientState(GL_COLOR_ARRAY);
+				glLineWidth(1);
+			}
+		}
+
+		for (const Renderable* each : unbatched) {
 			each->render(frames);
 		}
 	}
@@ -1712,17 +1119,14 @@ struct DrawPlane : UITrigger {
 	void renderScene(Camera& c) {
 		c.applyViewport();
 		c.applyProjection();
+		buildCubeBatch(c);
 
 		glMatrixMode(GL_MODELVIEW);
 		glShadeModel(GL_SMOOTH);
 		glLoadIdentity();
 
 		c.eyeCoords();
-		glColor3f(0.3, 0.3, 0.3);
-		drawGrid(0);
-
-		glColor3f(0.3, 0.3, 0.5);
-		drawGrid(3);
+		staticGeometry.draw(GL_LINES, 0, gridsCount);
 		
 		glEnable(GL_DEPTH_TEST);
 		
@@ -1732,35 +1136,108 @@ struct DrawPlane : UITrigger {
 		glPopMatrix();
 
 		renderTexturedPlane();
-		renderTraceLines();
-		renderMarkers();
-		if (cursorId != -1) {
-			renderCursorMarker();
-		}
+		frameLines.draw(GL_LINES);
 
 		renderRenderables();
 		glDisable(GL_DEPTH_TEST);
 	}
 
+	// bottom left corner of the view; overlay has y going down
+	void renderViewStats(const Camera& c) {
+		string text = "visible " + to_string(c.stats.visible) + " culled " + to_string(c.stats.culled);
+		TextPainter.addString(overlay, text, c.viewPos.x + 4, App.windowHeight - c.viewPos.y - TextPainter.fontCharHeight - 2);
+	}
+
+	// counts of the previous frame, this one is not drawn yet; top right corner
+	void renderOverlayStats() {
+		string text = "overlay " + to_string(overlay.stats.drawCalls) + " draws " + to_string(overlay.stats.stateChanges) + " state changes";
+
+		int width, height;
+		TextPainter.textSize(text, width, height);
+		TextPainter.addString(overlay, text, App.windowWidth - width - 4, 2);
+	}
+
+	// untextured quads and lines first, then glyphs with font texture; a kind with nothing in it costs nothing
+	void drawOverlay() {
+		overlay.finish();
+		const vector<TextVertex>& v = overlay.vertices;
+		overlayBuffer.upload(v.data(), v.size() * sizeof(TextVertex), v.capacity() * sizeof(TextVertex));
+
+		OverlayStats& stats = overlay.stats;
+		stats = OverlayStats();
+		if (v.empty()) {
+			return;
+		}
+
+		overlayBuffer.bindArrays(GL_T2F_C3F_V3F, v.data());
+
+		const int* first = overlay.first;
+		const int* count = overlay.count;
+		if (count[OverlayBatch::OverlayFill] + count[OverlayBatch::OverlayLines] > 0) {
+			glDisable(GL_TEXTURE_2D);
+			++stats.stateChanges;
+		}
+
+		if (count[OverlayBatch::OverlayFill] > 0) {
+			glDrawArrays(GL_QUADS, first[OverlayBatch::OverlayFill], count[OverlayBatch::OverlayFill]);
+			++stats.drawCalls;
+		}
+
+		if (count[OverlayBatch::OverlayLines] > 0) {
+			glDrawArrays(GL_LINES, first[OverlayBatch::OverlayLines], count[OverlayBatch::OverlayLines]);
+			++stats.drawCalls;
+		}
+
+		if (count[OverlayBatch::OverlayGlyphs] > 0) {
+			glEnable(GL_TEXTURE_2D);
+			TextPainter.bindTexture();
+			stats.stateChanges += 2;
+
+			glDrawArrays(GL_QUADS, first[OverlayBatch::OverlayGlyphs], count[OverlayBatch::OverlayGlyphs]);
+			++stats.drawCalls;
+		}
+
+		overlayBuffer.unbind();
+	}
+
+	// everything 2D is collected into overlay, then drawn at once
 	void renderOverlay2D() {
 		consoleView.applyViewport();
 		consoleView.applyProjection();
 
 		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
 		glPushAttrib(GL_ENABLE_BIT);
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
 		glEnable(GL_BLEND);
-		glEnable(GL_TEXTURE_2D);
+
+		overlay.clear();
 
 		if (!App.mouseCaptureMode) {
-			glLoadIdentity();
-			mainUI.render();
+			mainUI.render(overlay);
 		}
 
 		if (Log.unreadMessages > 0) {
-			glLoadIdentity();
 			showMessages();
 		}
 
+		if (multiViewEnabled) {
+			renderViewStats(camera);
+			renderViewStats(cameraXZ);
+			renderViewStats(cameraXY);
+			renderViewStats(cameraZY);
+		}
+		else {
+			renderViewStats(camera);
+		}
+		renderOverlayStats();
+
+		drawOverlay();
+
+		// text meshes not drawn in this frame are let go
+		TextPainter.meshes.endFrame();
+
+		glPopClientAttrib();
 		glPopAttrib();
 	}
 
@@ -1772,6 +1249,7 @@ struct DrawPlane : UITrigger {
 		glClear(GL_DEPTH_BUFFER_BIT);
 
 		applyMoves(camera);
+		buildFrameLines();
 
 		if (multiViewEnabled) {
 			XYFloat viewSize = { (float)(App.windowWidth / 2), (float)(App.windowHeight / 2) };
@@ -1813,38 +1291,20 @@ struct DrawPlane : UITrigger {
 		glRotatef(spin, 0, 1, 0);
 		glRotatef(45, 1, 0, 0);
 
-
-		glColor4f(1, 1, 1, 1);
-		glBegin(GL_QUADS);
-
-		glColor3f(1, 1, 0);  glVertex2f(-1, -1);
-		glColor3f(1, 0, 1);  glVertex2f(1, -1);
-		glColor3f(0, 1, 1);  glVertex2f(1, 1);
-		glColor3f(1, 1, 1);  glVertex2f(-1, 1);
-
-		glEnd();
+		staticGeometry.draw(GL_QUADS, quadFirst, 4);
 		glPopMatrix();
 	}
-
-	void drawGrid(GLfloat y) {
-		glBegin(GL_LINES);
-		for (int x = -10; x <= 10; ++x) {
-			glVertex3f(x, y, -10);
-			glVertex3f(x, y, 10);
-		}
-
-		for (int z = -10; z <= 10; ++z) {
-			glVertex3f(-10, y, z);
-			glVertex3f(10, y, z);
-		}
-		glEnd();
-	}
-
 };
 
 int main(int argc, char** argv) {
+	// --log <file> keeps every logged line, not only what fits in Log
+	if (argc > 2 && strcmp(argv[1], "--log") == 0 && !Log.spillTo(argv[2])) {
+		cerr << "[ERROR] failed to open log file " << argv[2] << "\n";
+	}
+	Log.startWriter();
+
 	if (!App.startSDL()) {
-		Log.printf("Failed to start, error: %i\n", App.lastError);
+		Log.printfAt(LogError, "Failed to start, error: %s\n", App.lastError.c_str());
 		return 1;
 	}
 
@@ -1932,6 +1392,9 @@ int main(int argc, char** argv) {
 				if (keyEvent->key == SDLK_GRAVE) {
 					Log.printf("CONSOLE\n");
 				}
+				else if (keyEvent->key == SDLK_DELETE) {
+					d.removePointed();
+				}
 				else if (keyEvent->key == SDLK_KP_PLUS) {
 					d.camera.updateFov(d.camera.fov + d.fovDiff);
 					Log.printf("FOV: %f\n", d.camera.fov);
@@ -1954,10 +1417,12 @@ int main(int argc, char** argv) {
 				}
 				else if (keyEvent->key == SDLK_8) {
 					d.movement = MoveHybrid;
+					d.camera.setOrientationMode(OrientationEuler);
 					Log.printf("Movement: hybrid\n");
 				}
 				else if (keyEvent->key == SDLK_9) {
 					d.movement = MoveXYZ;
+					d.camera.setOrientationMode(OrientationEuler);
 					d.camera.angle.z = 0;
 					Log.printf("Movement: xyz\n");
 				}
@@ -1970,7 +1435,7 @@ int main(int argc, char** argv) {
 				break;
 			}
 			else if (showEvent) {
-				Log.printf("Event %i\n", event.type);
+				LOG_DEBUG("Event %i\n", event.type);
 			}
 		}
 		else {
@@ -0,0 +1,55 @@
+#include <overlaybatch.h>
+
+static TextVertex plainVertex(float x, float y, const UIRGB& c) {
+	return { 0, 0, c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, x, y, 0 };
+}
+
+void OverlayBatch::clear() {
+	for (vector<TextVertex>& each : collected) {
+		each.clear();
+	}
+	vertices.clear();
+}
+
+void OverlayBatch::addQuad(float x, float y, float w, float h, const UIFillRGB& c) {
+	vector<TextVertex>& fill = collected[OverlayFill];
+	fill.push_back(plainVertex(x, y + h, c.bottom));
+	fill.push_back(plainVertex(x + w, y + h, c.bottom));
+	fill.push_back(plainVertex(x + w, y, c.top));
+	fill.push_back(plainVertex(x, y, c.top));
+}
+
+void OverlayBatch::addFrame(float x, float y, float w, float h, const UIFillRGB& c) {
+	TextVertex corners[4] = {
+		plainVertex(x, y + h, c.bottom),
+		plainVertex(x + w, y + h, c.bottom),
+		plainVertex(x + w, y, c.top),
+		plainVertex(x, y, c.top),
+	};
+
+	vector<TextVertex>& lines = collected[OverlayLines];
+	for (int i = 0; i < 4; ++i) {
+		lines.push_back(corners[i]);
+		lines.push_back(corners[(i + 1) % 4]);
+	}
+}
+
+void OverlayBatch::addText(const TextMesh& mesh, float x, float y) {
+	vector<TextVertex>& glyphs = collected[OverlayGlyphs];
+	size_t start = glyphs.size();
+	glyphs.insert(glyphs.end(), mesh.vertices.begin(), mesh.vertices.end());
+
+	for (size_t i = start; i < glyphs.size(); ++i) {
+		glyphs[i].x += x;
+		glyphs[i].y += y;
+	}
+}
+
+void OverlayBatch::finish() {
+	vertices.clear();
+	for (int k = 0; k < OVERLAY_KINDS; ++k) {
+		first[k] = (int)vertices.size();
+		count[k] = (int)collected[k].size();
+		vertices.insert(vertices.end(), collected[k].begin(), collected[k].end());
+	}
+}
@@ -0,0 +1,138 @@
+#include <scenemesh.h>
+#include <algorithm>
+
+bool SceneMesh::update(const vector<shared_ptr<Renderable>>& renderables) {
+	return update(nullptr, renderables);
+}
+
+bool SceneMesh::update(const SceneStore& store) {
+	return update(&store, store.renderables);
+}
+
+bool SceneMesh::update(const SceneStore* store, const vector<shared_ptr<Renderable>>& renderables) {
+	bool changed = store != meshedStore || (store && store->layout != storeLayout)
+		|| entries.size() > renderables.size() || !sameLayout(renderables, entries.size());
+
+	moved.clear();
+	if (!changed) {
+		if (store) {
+			remeshCubes(*store);
+		}
+
+		// mesh changed its shape, offsets of everything after it are off
+		changed = !remeshEntries();
+	}
+
+	if (changed) {
+		clear();
+		if (store) {
+			store->meshCubes(tris);
+			cubeVersions = store->versions;
+			storeLayout = store->layout;
+		}
+		meshedStore = store;
+	}
+
+	bool appended = false;
+	for (size_t i = entries.size(); i < renderables.size(); ++i) {
+		append(renderables[i].get());
+		appended = true;
+	}
+
+	if (changed || appended) {
+		bvh.build(tris);
+		soa.assign(tris, bvh.order);
+		++rebuilds;
+		return true;
+	}
+
+	if (!moved.empty()) {
+		// walking up from a few leaves is cheaper than touching every node
+		if (moved.size() * 8 < entries.size() + cubeVersions.size()) {
+			for (const Range& r : moved) {
+				bvh.refit(tris, r.first, r.count);
+
+				for (int t = r.first; t < r.first + r.count; ++t) {
+					soa.set(bvh.slotOf[t], tris[t]);
+				}
+			}
+		}
+		else {
+			bvh.refit(tris);
+			soa.assign(tris, bvh.order);
+		}
+
+		++refits;
+		return true;
+	}
+
+	return false;
+}
+
+void SceneMesh::remeshCubes(const SceneStore& store) {
+	for (int i = 0; i < store.cubeCount(); ++i) {
+		if (cubeVersions[i] == store.versions[i]) {
+			continue;
+		}
+
+		scratch.clear();
+		store.meshCube(i, scratch);
+
+		int first = i * CubeShape::TRIANGLES;
+		copy(scratch.begin(), scratch.end(), tris.begin() + first);
+		cubeVersions[i] = store.versions[i];
+		moved.push_back({ first, CubeShape::TRIANGLES });
+	}
+}
+
+bool SceneMesh::remeshEntries() {
+	for (Entry& e : entries) {
+		if (e.version == e.renderable->version) {
+			continue;
+		}
+
+		scratch.clear();
+		e.renderable->mesh(scratch);
+
+		if ((int)scratch.size() != e.count) {
+			return false;
+		}
+
+		copy(scratch.begin(), scratch.end(), tris.begin() + e.first);
+		e.version = e.renderable->version;
+		moved.push_back({ e.first, e.count });
+	}
+
+	return true;
+}
+
+void SceneMesh::clear() {
+	entries.clear();
+	tris.clear();
+	cubeVersions.clear();
+	meshedStore = nullptr;
+	bvh = BVH();
+	soa = TriangleSoA();
+}
+
+void SceneMesh::append(const Renderable* r) {
+	Entry e;
+	e.renderable = r;
+	e.version = r->version;
+	e.first = (int)tris.size();
+
+	r->mesh(tris);
+	e.count = (int)tris.size() - e.first;
+
+	entries.push_back(e);
+}
+
+bool SceneMesh::sameLayout(const vector<shared_ptr<Renderable>>& renderables, size_t count) const {
+	for (size_t i = 0; i < count; ++i) {
+		if (entries[i].renderable != renderables[i].get()) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,207 @@
+#include <scenestore.h>
+
+int SceneStore::addCube(const CubeShape& c) {
+	int id = handles.insert({ true, cubeCount() });
+	if (id == -1) {
+		return -1;
+	}
+
+	ids.push_back(id);
+	shapes.push_back(c);
+	shapes.back().id = id;
+	models.push_back(c.modelMatrix());
+	versions.push_back(0);
+	selected.push_back(0);
+	grid.insert(id, CubeShape::boundsOf(models.back()));
+
+	++layout;
+	return id;
+}
+
+int SceneStore::addRenderable(const shared_ptr<Renderable>& r) {
+	int id = handles.insert({ false, (int)renderables.size() });
+	if (id == -1) {
+		return -1;
+	}
+
+	r->id = id;
+	renderables.push_back(r);
+	renderableVersions.push_back(r->version);
+	grid.insert(r->id, r->bounds());
+	return r->id;
+}
+
+bool SceneStore::remove(int id) {
+	const Location* at = handles.find(id);
+	if (!at) {
+		return false;
+	}
+
+	int index = at->index;
+	if (at->cube) {
+		int last = cubeCount() - 1;
+		if (index != last) {
+			ids[index] = ids[last];
+			shapes[index] = shapes[last];
+			models[index] = models[last];
+			versions[index] = versions[last];
+			selected[index] = selected[last];
+			handles.find(ids[index])->index = index;
+		}
+
+		ids.pop_back();
+		shapes.pop_back();
+		models.pop_back();
+		versions.pop_back();
+		selected.pop_back();
+	}
+	else {
+		int last = (int)renderables.size() - 1;
+		if (index != last) {
+			renderables[index] = renderables[last];
+			renderableVersions[index] = renderableVersions[last];
+			handles.find(renderables[index]->id)->index = index;
+		}
+
+		renderables.pop_back();
+		renderableVersions.pop_back();
+	}
+
+	// a renderable added later may get the address of a removed one, so mesh cannot tell them apart by pointer
+	++layout;
+
+	handles.remove(id);
+	grid.remove(id);
+	return true;
+}
+
+void SceneStore::clear() {
+	handles.clear();
+	ids.clear();
+	shapes.clear();
+	models.clear();
+	versions.clear();
+	selected.clear();
+	renderables.clear();
+	renderableVersions.clear();
+	grid.clear();
+
+	++layout;
+}
+
+void SceneStore::moveCube(int index, const Vec3F& pos) {
+	shapes[index].pos = pos;
+	cubeChanged(index);
+}
+
+void SceneStore::rotateCube(int index, const Vec3F& angle) {
+	shapes[index].angle = angle;
+	shapes[index].orientationMode = OrientationEuler;
+	cubeChanged(index);
+}
+
+void SceneStore::scaleCube(int index, const Vec3F& scale) {
+	shapes[index].scale = scale;
+	cubeChanged(index);
+}
+
+void SceneStore::orientCube(int index, const Quat& orientation) {
+	shapes[index].orientation = orientation;
+	shapes[index].orientationMode = OrientationQuat;
+	cubeChanged(index);
+}
+
+void SceneStore::cubeChanged(int index) {
+	models[index] = shapes[index].modelMatrix();
+	++versions[index];
+	grid.move(ids[index], CubeShape::boundsOf(models[index]));
+}
+
+int SceneStore::cubeForId(int id) const {
+	const Location* at = handles.find(id);
+	return at && at->cube ? at->index : -1;
+}
+
+Renderable* SceneStore::renderableForId(int id) const {
+	const Location* at = handles.find(id);
+	return at && !at->cube ? renderables[at->index].get() : nullptr;
+}
+
+bool SceneStore::toggleSelect(int id) {
+	int cube = cubeForId(id);
+	if (cube != -1) {
+		selected[cube] = !selected[cube];
+		return true;
+	}
+
+	Renderable* r = renderableForId(id);
+	if (r) {
+		r->toggleSelect();
+		return true;
+	}
+
+	return false;
+}
+
+void SceneStore::syncBounds() {
+	for (size_t i = 0; i < renderables.size(); ++i) {
+		const Renderable& r = *renderables[i];
+		if (renderableVersions[i] != r.version) {
+			grid.move(r.id, r.bounds());
+			renderableVersions[i] = r.version;
+		}
+	}
+}
+
+void SceneStore::batch(CubeBatch& batch, vector<const Renderable*>& unbatched) const {
+	for (int i = 0; i < cubeCount(); ++i) {
+		batch.add(models[i], selected[i] != 0);
+	}
+
+	for (const shared_ptr<Renderable>& each : renderables) {
+		if (!each->addToBatch(batch)) {
+			unbatched.push_back(each.get());
+		}
+	}
+}
+
+void SceneStore::batch(CubeBatch& batch, vector<const Renderable*>& unbatched, const vector<int>& objectIds) const {
+	for (int id : objectIds) {
+		const Location* at = handles.find(id);
+		if (!at) {
+			continue;
+		}
+
+		if (at->cube) {
+			batch.add(models[at->index], selected[at->index] != 0);
+		}
+		else if (!renderables[at->index]->addToBatch(batch)) {
+			unbatched.push_back(renderables[at->index].get());
+		}
+	}
+}
+
+void SceneStore::meshCubes(vector<Triangle>& fill) const {
+	fill.reserve(fill.size() + (size_t)cubeCount() * CubeShape::TRIANGLES);
+	for (int i = 0; i < cubeCount(); ++i) {
+		shapes[i].meshShape(models[i], fill);
+	}
+}
+
+void SceneStore::meshCube(int index, vector<Triangle>& fill) const {
+	shapes[index].meshShape(models[index], fill);
+}
+
+void SceneStore::meshObject(int id, vector<Triangle>& fill) const {
+	const Location* at = handles.find(id);
+	if (!at) {
+		return;
+	}
+
+	if (at->cube) {
+		meshCube(at->index, fill);
+	}
+	else {
+		renderables[at->index]->mesh(fill);
+	}
+}
@@ -0,0 +1,291 @@
+#include <spatialgrid.h>
+#include <algorithm>
+
+static bool boxesOverlap(const AABB& a, const AABB& b) {
+	return a.lo.x <= b.hi.x && a.hi.x >= b.lo.x
+		&& a.lo.y <= b.hi.y && a.hi.y >= b.lo.y
+		&& a.lo.z <= b.hi.z && a.hi.z >= b.lo.z;
+}
+
+static SpatialGrid::CellRange noCells() {
+	return { { 0, 0, 0 }, { -1, -1, -1 } };
+}
+
+void SpatialGrid::insert(int id, const AABB& box) {
+	auto found = slots.find(id);
+	if (found != slots.end()) {
+		move(id, box);
+		return;
+	}
+
+	int index = (int)entries.size();
+	slots[id] = index;
+	entries.push_back({ id, box, cellsFor(box), {}, -1 });
+	marks.push_back(0);
+
+	if (entries[index].cells.volume() > 0) {
+		bounds.grow(box);
+		addToCells(index, noCells());
+	}
+	else if (!box.empty()) {
+		addToLarge(index);
+	}
+}
+
+void SpatialGrid::remove(int id) {
+	auto found = slots.find(id);
+	if (found == slots.end()) {
+		return;
+	}
+
+	int index = found->second;
+	int last = (int)entries.size() - 1;
+	slots.erase(found);
+
+	const CellRange& r = entries[index].cells;
+	for (int x = r.lo[0]; x <= r.hi[0]; ++x)
+	for (int y = r.lo[1]; y <= r.hi[1]; ++y)
+	for (int z = r.lo[2]; z <= r.hi[2]; ++z) {
+		removeFromCell(index, x, y, z);
+	}
+	if (entries[index].largeAt >= 0) {
+		removeFromLarge(index);
+	}
+
+	if (index != last) {
+		relabel(last, index);
+		swap(entries[index], entries[last]);
+		marks[index] = marks[last];
+		slots[entries[index].id] = index;
+	}
+	entries.pop_back();
+	marks.pop_back();
+}
+
+void SpatialGrid::move(int id, const AABB& box) {
+	auto found = slots.find(id);
+	if (found == slots.end()) {
+		insert(id, box);
+		return;
+	}
+
+	int index = found->second;
+	Entry& e = entries[index];
+	CellRange r = cellsFor(box);
+	e.box = box;
+
+	bool inLarge = r.volume() == 0 && !box.empty();
+	if (inLarge != (e.largeAt >= 0)) {
+		if (inLarge) {
+			addToLarge(index);
+		}
+		else {
+			removeFromLarge(index);
+		}
+	}
+
+	if (r.volume() > 0) {
+		bounds.grow(box);
+	}
+
+	if (r == e.cells) {
+		return;
+	}
+
+	// only cells which are in one range and not in the other
+	CellRange old = e.cells;
+	for (int x = old.lo[0]; x <= old.hi[0]; ++x)
+	for (int y = old.lo[1]; y <= old.hi[1]; ++y)
+	for (int z = old.lo[2]; z <= old.hi[2]; ++z) {
+		if (!r.contains(x, y, z)) {
+			removeFromCell(index, x, y, z);
+		}
+	}
+
+	e.cells = r;
+	addToCells(index, old);
+}
+
+void SpatialGrid::clear() {
+	cells.clear();
+	entries.clear();
+	large.clear();
+	slots.clear();
+	marks.clear();
+	bounds = AABB();
+}
+
+SpatialGrid::CellRange SpatialGrid::cellsFor(const AABB& box) const {
+	if (box.empty()) {
+		return noCells();
+	}
+
+	CellRange r = rangeOf(box);
+	return r.volume() > MAX_ENTRY_CELLS ? noCells() : r;
+}
+
+void SpatialGrid::addToCells(int index, const CellRange& keep) {
+	Entry& e = entries[index];
+	const CellRange& r = e.cells;
+
+	// positions in kept cells move over from at of the old range
+	kept.assign(r.volume(), 0);
+	for (int x = r.lo[0]; x <= r.hi[0]; ++x)
+	for (int y = r.lo[1]; y <= r.hi[1]; ++y)
+	for (int z = r.lo[2]; z <= r.hi[2]; ++z) {
+		int i = cellIndex(r, x, y, z);
+		if (keep.contains(x, y, z)) {
+			kept[i] = e.at[cellIndex(keep, x, y, z)];
+			continue;
+		}
+
+		vector<int>& listed = cells[key(x, y, z)];
+		kept[i] = (int)listed.size();
+		listed.push_back(index);
+	}
+
+	e.at.swap(kept);
+}
+
+void SpatialGrid::removeFromCell(int index, int x, int y, int z) {
+	auto cell = cells.find(key(x, y, z));
+	vector<int>& listed = cell->second;
+
+	int at = entries[index].at[cellIndex(entries[index].cells, x, y, z)];
+	int moved = listed.back();
+	listed[at] = moved;
+	listed.pop_back();
+
+	if (moved != index) {
+		entries[moved].at[cellIndex(entries[moved].cells, x, y, z)] = at;
+	}
+
+	if (listed.empty()) {
+		cells.erase(cell);
+	}
+}
+
+void SpatialGrid::addToLarge(int index) {
+	entries[index].largeAt = (int)large.size();
+	large.push_back(index);
+}
+
+void SpatialGrid::removeFromLarge(int index) {
+	int at = entries[index].largeAt;
+	int moved = large.back();
+	large[at] = moved;
+	large.pop_back();
+
+	entries[moved].largeAt = at;
+	entries[index].largeAt = -1;
+}
+
+void SpatialGrid::relabel(int from, int to) {
+	const Entry& e = entries[from];
+	const CellRange& r = e.cells;
+	for (int x = r.lo[0]; x <= r.hi[0]; ++x)
+	for (int y = r.lo[1]; y <= r.hi[1]; ++y)
+	for (int z = r.lo[2]; z <= r.hi[2]; ++z) {
+		cells[key(x, y, z)][e.at[cellIndex(r, x, y, z)]] = to;
+	}
+
+	if (e.largeAt >= 0) {
+		large[e.largeAt] = to;
+	}
+}
+
+// a cell lookup misses cache about as often as scanning this many dense entries does
+static const int SCAN_PER_CELL = 8;
+
+void SpatialGrid::nextMark() const {
+	if (++mark == 0) {
+		fill(marks.begin(), marks.end(), 0);
+		mark = 1;
+	}
+}
+
+template <typename C, typename B> void SpatialGrid::query(const CellRange& r, C cellTest, B boxTest, vector<int>& ids) const {
+	ids.clear();
+
+	if (r.volume() > (long long)entries.size() / SCAN_PER_CELL) {
+		for (const Entry& e : entries) {
+			if (!e.box.empty() && boxTest(e.box)) {
+				ids.push_back(e.id);
+			}
+		}
+
+		sort(ids.begin(), ids.end());
+		return;
+	}
+
+	nextMark();
+
+	for (int x = r.lo[0]; x <= r.hi[0]; ++x)
+	for (int y = r.lo[1]; y <= r.hi[1]; ++y)
+	for (int z = r.lo[2]; z <= r.hi[2]; ++z) {
+		auto cell = cells.find(key(x, y, z));
+		if (cell == cells.end()) {
+			continue;
+		}
+
+		AABB cellBox;
+		cellBox.lo = { x * cellSize, y * cellSize, z * cellSize };
+		cellBox.hi = { (x + 1) * cellSize, (y + 1) * cellSize, (z + 1) * cellSize };
+		if (!cellTest(cellBox)) {
+			continue;
+		}
+
+		for (int index : cell->second) {
+			if (marks[index] == mark) {
+				continue;
+			}
+			marks[index] = mark;
+
+			if (boxTest(entries[index].box)) {
+				ids.push_back(entries[index].id);
+			}
+		}
+	}
+
+	for (int index : large) {
+		if (boxTest(entries[index].box)) {
+			ids.push_back(entries[index].id);
+		}
+	}
+
+	sort(ids.begin(), ids.end());
+}
+
+void SpatialGrid::queryBox(const AABB& box, vector<int>& ids) const {
+	if (entries.empty() || box.empty()) {
+		ids.clear();
+		return;
+	}
+
+	query(rangeOf(box),
+		[&](const AABB&) { return true; },
+		[&](const AABB& b) { return boxesOverlap(b, box); },
+		ids);
+}
+
+void SpatialGrid::queryFrustum(const Frustum& f, vector<int>& ids) const {
+	ids.clear();
+	if (entries.empty()) {
+		return;
+	}
+
+	// frustum corners bound it, then clipped to what is occupied at all
+	AABB around;
+	for (const Vec3F& c : f.corners) {
+		around.grow(c);
+	}
+
+	around.lo = { fmaxf(around.lo.x, bounds.lo.x), fmaxf(around.lo.y, bounds.lo.y), fmaxf(around.lo.z, bounds.lo.z) };
+	around.hi = { fminf(around.hi.x, bounds.hi.x), fminf(around.hi.y, bounds.hi.y), fminf(around.hi.z, bounds.hi.z) };
+
+	// large objects may still be there with no cell in it
+	query(around.empty() ? noCells() : rangeOf(around),
+		[&](const AABB& cellBox) { return f.classify(cellBox) != FrustumOutside; },
+		[&](const AABB& b) { return f.classify(b) != FrustumOutside; },
+		ids);
+}
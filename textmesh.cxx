@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <textmesh.h>
+
+static bool sameRGB(const UIRGB& a, const UIRGB& b) {
+	return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+bool TextMesh::matches(const TextLayout& layout, const UIFillRGB& aColor) const {
+	return sameRGB(color.top, aColor.top) && sameRGB(color.bottom, aColor.bottom)
+		&& charWidth == layout.fontCharWidth && charHeight == layout.fontCharHeight;
+}
+
+void TextMesh::build(const TextLayout& layout, const string& aText, const UIFillRGB& aColor) {
+	text = aText;
+	color = aColor;
+	charWidth = layout.fontCharWidth;
+	charHeight = layout.fontCharHeight;
+	vertices.clear();
+
+	float w = (float)charWidth;
+	float h = (float)charHeight;
+	float tW = layout.glyphW;
+	float tH = layout.glyphH;
+
+	float topR = color.top.r / 255.0f, topG = color.top.g / 255.0f, topB = color.top.b / 255.0f;
+	float bottomR = color.bottom.r / 255.0f, bottomG = color.bottom.g / 255.0f, bottomB = color.bottom.b / 255.0f;
+
+	float oX = 0;
+	float oY = 0;
+	for (const char c : text) {
+		if (c == '\t') {
+			int xIdx = oX / charWidth;
+			int tabbedIdx = (xIdx / layout.TAB_SIZE + 1) * layout.TAB_SIZE;
+			oX = tabbedIdx * w;
+		}
+		else if (c == '\n') {
+			oX = 0;
+			oY += h;
+		}
+		else if (c == ' ') {
+			oX += w;
+		}
+		else {
+			float tX = layout.glyph(c).x;
+			float tY = layout.glyph(c).y;
+
+			vertices.push_back({ tX + tW, tY, topR, topG, topB, oX + w, oY, 0 });
+			vertices.push_back({ tX, tY, topR, topG, topB, oX, oY, 0 });
+			vertices.push_back({ tX, tY + tH, bottomR, bottomG, bottomB, oX, oY + h, 0 });
+			vertices.push_back({ tX + tW, tY + tH, bottomR, bottomG, bottomB, oX + w, oY + h, 0 });
+
+			oX += w;
+		}
+	}
+}
+
+const TextMesh& TextMeshCache::get(const TextLayout& layout, const string& text, const UIFillRGB& color) {
+	auto found = meshes.find(text);
+	if (found == meshes.end()) {
+		found = meshes.emplace(text, vector<TextMesh>()).first;
+	}
+
+	vector<TextMesh>& variants = found->second;
+	for (TextMesh& each : variants) {
+		if (each.matches(layout, color)) {
+			each.used = frame;
+			return each;
+		}
+	}
+
+	variants.emplace_back();
+	TextMesh& mesh = variants.back();
+	mesh.build(layout, text, color);
+	mesh.used = frame;
+	return mesh;
+}
+
+void TextMeshCache::endFrame() {
+	for (auto it = meshes.begin(); it != meshes.end();) {
+		vector<TextMesh>& variants = it->second;
+		variants.erase(remove_if(variants.begin(), variants.end(), [&](const TextMesh& m) { return m.used != frame; }), variants.end());
+
+		if (variants.empty()) {
+			it = meshes.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	++frame;
+}
@@ -0,0 +1,84 @@
+#include <threadpool.h>
+
+ThreadPool::ThreadPool(int threads) : nextTask(0) {
+	for (int i = 1; i < threads; ++i) {
+		workers.emplace_back([this] { work(); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (thread& each : workers) {
+		each.join();
+	}
+}
+
+int ThreadPool::defaultSize() {
+	int cores = (int)thread::hardware_concurrency();
+	return cores > 0 ? cores : 1;
+}
+
+void ThreadPool::takeTasks(const function<void(int)>& task, int tasks) {
+	for (int i = nextTask++; i < tasks; i = nextTask++) {
+		task(i);
+	}
+}
+
+void ThreadPool::run(int tasks, const function<void(int)>& task) {
+	if (workers.empty() || tasks <= 1) {
+		for (int i = 0; i < tasks; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		job = &task;
+		jobTasks = tasks;
+		nextTask = 0;
+		busyWorkers = (int)workers.size();
+		++jobGeneration;
+	}
+	wake.notify_all();
+
+	takeTasks(task, tasks);
+
+	// task lives on caller stack, so every worker has to let go of it before returning
+	unique_lock<mutex> guard(lock);
+	done.wait(guard, [this] { return busyWorkers == 0; });
+	job = nullptr;
+}
+
+void ThreadPool::work() {
+	unsigned seenGeneration = 0;
+
+	for (;;) {
+		const function<void(int)>* task;
+		int tasks;
+		{
+			unique_lock<mutex> guard(lock);
+			wake.wait(guard, [&] { return stopping || jobGeneration != seenGeneration; });
+			if (stopping) {
+				return;
+			}
+
+			seenGeneration = jobGeneration;
+			task = job;
+			tasks = jobTasks;
+		}
+
+		takeTasks(*task, tasks);
+
+		{
+			lock_guard<mutex> guard(lock);
+			--busyWorkers;
+		}
+		done.notify_one();
+	}
+}
@@ -1,9 +1,10 @@
 #include <trig.h>
 #include <log.h>
 #include <m44.h>
+#include <cmath>
 
 void Vec3F::Print() const{
-	Log.printf("[ %f\t%f\t%f ]\n", x, y, z);
+	LOG_DEBUG("[ %f\t%f\t%f ]\n", x, y, z);
 }
 
 Vec3F& Vec3F::normalize() {
@@ -0,0 +1,247 @@
+#include <trisoa.h>
+#include <cmath>
+#include <algorithm>
+
+#ifdef EXPLORER_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+SoAArrays::SoAArrays(const TriangleSoA& soa) :
+	v0x(soa.v0x.data()), v0y(soa.v0y.data()), v0z(soa.v0z.data()),
+	e1x(soa.e1x.data()), e1y(soa.e1y.data()), e1z(soa.e1z.data()),
+	e2x(soa.e2x.data()), e2y(soa.e2y.data()), e2z(soa.e2z.data()) {
+}
+
+void TriangleSoA::resize(int n) {
+	count = n;
+
+	// ranges may start anywhere (bvh leaves), so a full vector load from the last triangle must stay inside
+	int padded = n + WIDTH;
+
+	// padding stays zero: e1 = e2 = 0 gives det == 0, which never hits
+	for (vector<float>* each : { &v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z }) {
+		each->assign(padded, 0);
+	}
+	ids.assign(padded, -1);
+}
+
+void TriangleSoA::set(int idx, const Triangle& t) {
+	const Vec3F& v0 = t.vertices[0];
+	const Vec3F& v1 = t.vertices[1];
+	const Vec3F& v2 = t.vertices[2];
+
+	v0x[idx] = v0.x; v0y[idx] = v0.y; v0z[idx] = v0.z;
+	e1x[idx] = v1.x - v0.x; e1y[idx] = v1.y - v0.y; e1z[idx] = v1.z - v0.z;
+	e2x[idx] = v2.x - v0.x; e2y[idx] = v2.y - v0.y; e2z[idx] = v2.z - v0.z;
+	ids[idx] = t.id;
+}
+
+void TriangleSoA::assign(const vector<Triangle>& tris) {
+	resize((int)tris.size());
+	for (int i = 0; i < count; ++i) {
+		set(i, tris[i]);
+	}
+}
+
+void TriangleSoA::assign(const vector<Triangle>& tris, const vector<int>& order) {
+	resize((int)order.size());
+	for (int i = 0; i < count; ++i) {
+		set(i, tris[order[i]]);
+	}
+}
+
+void TriangleSoA::intersect(int first, int length, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out) const {
+	static const SoAKernel kernel = soaKernel(detectSimd());
+	kernel(*this, first, length, origin, dir, tMax, out);
+}
+
+// same steps and order of operations as HitTest::intersect, so results are equal to the last bit
+void intersectScalar(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out) {
+	for (int i = first; i < first + count; ++i) {
+		float e1x = soa.e1x[i], e1y = soa.e1y[i], e1z = soa.e1z[i];
+		float e2x = soa.e2x[i], e2y = soa.e2y[i], e2z = soa.e2z[i];
+
+		float px = dir.y * e2z - dir.z * e2y;
+		float py = dir.z * e2x - dir.x * e2z;
+		float pz = dir.x * e2y - dir.y * e2x;
+
+		float det = e1x * px + e1y * py + e1z * pz;
+		if (det == 0) {
+			continue;
+		}
+
+		float sign = copysignf(1.0f, det);
+		float absDet = det * sign;
+
+		float sx = origin.x - soa.v0x[i], sy = origin.y - soa.v0y[i], sz = origin.z - soa.v0z[i];
+		float uDet = (sx * px + sy * py + sz * pz) * sign;
+		if (fmaxf(-uDet, uDet - absDet) > 0) {
+			continue;
+		}
+
+		float qx = sy * e1z - sz * e1y;
+		float qy = sz * e1x - sx * e1z;
+		float qz = sx * e1y - sy * e1x;
+
+		float vDet = (dir.x * qx + dir.y * qy + dir.z * qz) * sign;
+		if (fmaxf(-vDet, uDet + vDet - absDet) > 0) {
+			continue;
+		}
+
+		float invDet = 1 / absDet;
+		float t = (e2x * qx + e2y * qy + e2z * qz) * sign * invDet;
+		if (t > 0 && t < tMax) {
+			out.push_back({ i, t, uDet * invDet, vDet * invDet });
+		}
+	}
+}
+
+#ifdef EXPLORER_X86
+
+void intersectSSE(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out) {
+	const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 tFar = _mm_set1_ps(tMax);
+
+	int end = first + count;
+	for (int i = first; i < end; i += 4) {
+		__m128 e1x = _mm_loadu_ps(&soa.e1x[i]), e1y = _mm_loadu_ps(&soa.e1y[i]), e1z = _mm_loadu_ps(&soa.e1z[i]);
+		__m128 e2x = _mm_loadu_ps(&soa.e2x[i]), e2y = _mm_loadu_ps(&soa.e2y[i]), e2z = _mm_loadu_ps(&soa.e2z[i]);
+
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 sign = _mm_or_ps(_mm_and_ps(det, signBit), one);
+		__m128 absDet = _mm_mul_ps(det, sign);
+
+		__m128 sx = _mm_sub_ps(ox, _mm_loadu_ps(&soa.v0x[i]));
+		__m128 sy = _mm_sub_ps(oy, _mm_loadu_ps(&soa.v0y[i]));
+		__m128 sz = _mm_sub_ps(oz, _mm_loadu_ps(&soa.v0z[i]));
+
+		__m128 uDet = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), sign);
+
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+		__m128 vDet = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), sign);
+		__m128 tDet = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), sign);
+
+		__m128 hit = _mm_cmpneq_ps(det, zero);
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_sub_ps(zero, uDet), zero));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_sub_ps(uDet, absDet), zero));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_sub_ps(zero, vDet), zero));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_sub_ps(_mm_add_ps(uDet, vDet), absDet), zero));
+
+		int mask = _mm_movemask_ps(hit);
+		if (end - i < 4) {
+			mask &= (1 << (end - i)) - 1;
+		}
+
+		if (!mask) {
+			continue;
+		}
+
+		// division only for vectors with a candidate
+		__m128 invDet = _mm_div_ps(one, absDet);
+		__m128 t = _mm_mul_ps(tDet, invDet);
+		mask &= _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, tFar)));
+
+		alignas(16) float ts[4], us[4], vs[4];
+		_mm_store_ps(ts, t);
+		_mm_store_ps(us, _mm_mul_ps(uDet, invDet));
+		_mm_store_ps(vs, _mm_mul_ps(vDet, invDet));
+
+		for (int lane = 0; lane < 4; ++lane) {
+			if (mask & (1 << lane)) {
+				out.push_back({ i + lane, ts[lane], us[lane], vs[lane] });
+			}
+		}
+	}
+}
+
+// hits of a block land on stack first; vector is only touched here, in code built without AVX2
+void intersectAVX2(const TriangleSoA& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, vector<SoAHit>& out) {
+	const int BLOCK = 32 * TriangleSoA::WIDTH;
+	SoAArrays arrays(soa);
+	SoAHit hits[BLOCK];
+
+	for (int from = first; from < first + count; from += BLOCK) {
+		int found = intersectAVX2Block(arrays, from, min(BLOCK, first + count - from), origin, dir, tMax, hits);
+		out.insert(out.end(), hits, hits + found);
+	}
+}
+
+static bool cpuHasAVX2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) {
+		return false;
+	}
+
+	// os has to save ymm registers on context switch
+	if ((_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+SimdLevel detectSimd() {
+#ifdef EXPLORER_X86
+	// SSE2 is part of x86-64, and required by any compiler setting we build 32 bit with
+	return cpuHasAVX2() ? SimdAVX2 : SimdSSE;
+#else
+	return SimdScalar;
+#endif
+}
+
+const char* simdName(SimdLevel level) {
+	switch (level) {
+	case SimdScalar: return "scalar";
+	case SimdSSE: return "sse";
+	case SimdAVX2: return "avx2";
+	}
+
+	return "?";
+}
+
+SoAKernel soaKernel(SimdLevel level) {
+#ifdef EXPLORER_X86
+	SimdLevel supported = detectSimd();
+	if (level > supported) {
+		level = supported;
+	}
+
+	switch (level) {
+	case SimdAVX2: return intersectAVX2;
+	case SimdSSE: return intersectSSE;
+	default: break;
+	}
+#endif
+
+	return intersectScalar;
+}
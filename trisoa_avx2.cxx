@@ -0,0 +1,79 @@
+// AVX2 kernel lives in its own file, so only this file is built with AVX2 enabled (see CMakeLists.txt);
+// it is called only after detectSimd() confirmed cpu support. Nothing here may instantiate inline or template code of
+// the STL: such code is emitted as weak symbols, and the linker could keep the AVX2 copy for the SSE path too.
+#include <trisoa.h>
+
+#ifdef EXPLORER_X86
+#include <immintrin.h>
+
+int intersectAVX2Block(const SoAArrays& soa, int first, int count, const Vec3F& origin, const Vec3F& dir, float tMax, SoAHit* out) {
+	const __m256 dx = _mm256_set1_ps(dir.x), dy = _mm256_set1_ps(dir.y), dz = _mm256_set1_ps(dir.z);
+	const __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+	const __m256 tFar = _mm256_set1_ps(tMax);
+
+	int hits = 0;
+	int end = first + count;
+	for (int i = first; i < end; i += 8) {
+		__m256 e1x = _mm256_loadu_ps(&soa.e1x[i]), e1y = _mm256_loadu_ps(&soa.e1y[i]), e1z = _mm256_loadu_ps(&soa.e1z[i]);
+		__m256 e2x = _mm256_loadu_ps(&soa.e2x[i]), e2y = _mm256_loadu_ps(&soa.e2y[i]), e2z = _mm256_loadu_ps(&soa.e2z[i]);
+
+		__m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+		__m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+		__m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+
+		__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+		__m256 sign = _mm256_or_ps(_mm256_and_ps(det, signBit), one);
+		__m256 absDet = _mm256_mul_ps(det, sign);
+
+		__m256 sx = _mm256_sub_ps(ox, _mm256_loadu_ps(&soa.v0x[i]));
+		__m256 sy = _mm256_sub_ps(oy, _mm256_loadu_ps(&soa.v0y[i]));
+		__m256 sz = _mm256_sub_ps(oz, _mm256_loadu_ps(&soa.v0z[i]));
+
+		__m256 uDet = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), sign);
+
+		__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+		__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+		__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+
+		__m256 vDet = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), sign);
+		__m256 tDet = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), sign);
+
+		__m256 hit = _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ);
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_sub_ps(zero, uDet), zero, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_sub_ps(uDet, absDet), zero, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_sub_ps(zero, vDet), zero, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_sub_ps(_mm256_add_ps(uDet, vDet), absDet), zero, _CMP_LE_OQ));
+
+		int mask = _mm256_movemask_ps(hit);
+		if (end - i < 8) {
+			mask &= (1 << (end - i)) - 1;
+		}
+
+		if (!mask) {
+			continue;
+		}
+
+		// division only for vectors with a candidate
+		__m256 invDet = _mm256_div_ps(one, absDet);
+		__m256 t = _mm256_mul_ps(tDet, invDet);
+		mask &= _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ), _mm256_cmp_ps(t, tFar, _CMP_LT_OQ)));
+
+		alignas(32) float ts[8], us[8], vs[8];
+		_mm256_store_ps(ts, t);
+		_mm256_store_ps(us, _mm256_mul_ps(uDet, invDet));
+		_mm256_store_ps(vs, _mm256_mul_ps(vDet, invDet));
+
+		for (int lane = 0; lane < 8; ++lane) {
+			if (mask & (1 << lane)) {
+				out[hits++] = { i + lane, ts[lane], us[lane], vs[lane] };
+			}
+		}
+	}
+
+	return hits;
+}
+
+#endif